@@ -120,6 +120,9 @@ struct load_param_t {
   int32_t displayPath;
   std::string windowId;
   std::string uri;
+  std::string mediaId;
+  std::string appId;
+  time_t startTime = 0;
 };
 
 }  // namespace base
@@ -54,7 +54,8 @@ MediaPlayerClient::MediaPlayerClient(const std::string& appId, const std::string
 MediaPlayerClient::~MediaPlayerClient() {
   GMP_DEBUG_PRINT("");
 
-  resourceRequestor_->setIsUnloading(true);
+  if (resourceRequestor_)
+    resourceRequestor_->setIsUnloading(true);
 
   if (isLoaded_) {
     GMP_DEBUG_PRINT("Unload() should be called if it is still loaded");
@@ -109,6 +110,9 @@ void MediaPlayerClient::LoadCommon() {
         std::placeholders::_1, std::placeholders::_2,
         std::placeholders::_3, std::placeholders::_4));
 
+  if (updateIntervalMs_)
+    player_->SetUpdateInterval(updateIntervalMs_);
+
   if (resourceRequestor_) {
     resourceRequestor_->registerUMSPolicyActionCallback([this]() {
       base::error_t error;
@@ -157,10 +161,22 @@ bool MediaPlayerClient::Load(const MEDIA_LOAD_DATA_T* loadData) {
   return true;
 }
 
-// Managed case
 bool MediaPlayerClient::Load(const std::string &str) {
   GMP_DEBUG_PRINT("Load loadData = %s", str.c_str());
-  player_ = gmp::pf::PlayerFactory::CreatePlayer(str, playerType_);
+  base::load_param_t param;
+  try {
+    param = gmp::parser::Parser(str.c_str()).get_load_param();
+  } catch (const gmp::parser::parser_error &e) {
+    GMP_INFO_PRINT("Error: %s", e.what());
+    return false;
+  }
+  return Load(param);
+}
+
+// Managed case
+bool MediaPlayerClient::Load(const base::load_param_t &param) {
+  GMP_DEBUG_PRINT("Load uri = %s", param.uri.c_str());
+  player_ = gmp::pf::PlayerFactory::CreatePlayer(param, playerType_);
 
   if (!player_) {
     GMP_INFO_PRINT("Error: Player not created");
@@ -169,7 +185,7 @@ bool MediaPlayerClient::Load(const std::string &str) {
 
   LoadCommon();
 
-  if (player_->Load(str)) {
+  if (player_->Load(param)) {
     GMP_DEBUG_PRINT("Loaded Player");
   } else {
     GMP_DEBUG_PRINT("Failed to load player");
@@ -205,6 +221,22 @@ bool MediaPlayerClient::Unload() {
   return true;
 }
 
+// Switches a loaded buffer player to new content, keeping its pipeline when
+// the player can. Falls back to Unload/Load otherwise.
+bool MediaPlayerClient::Reconfigure(const MEDIA_LOAD_DATA_T* loadData) {
+  GMP_DEBUG_PRINT("Reconfigure loadData = %p", loadData);
+  if (!isLoaded_ || !player_ || playerType_ != GMP_PLAYER_TYPE_BUFFER)
+    return (!isLoaded_ || Unload()) && Load(loadData);
+
+  if (player_->Reconfigure(loadData)) {
+    GMP_DEBUG_PRINT("Reconfigured Player");
+    return true;
+  }
+
+  GMP_INFO_PRINT("Reconfigure not possible, reload the player");
+  return Unload() && Load(loadData);
+}
+
 bool MediaPlayerClient::Play() {
   GMP_DEBUG_PRINT("");
   if (!player_ || !isLoaded_) {
@@ -248,6 +280,55 @@ MEDIA_STATUS_T MediaPlayerClient::Feed(const guint8* pBuffer,
   return player_->Feed(pBuffer, bufferSize, pts, esData);
 }
 
+// Zero-copy variant of Feed. pBuffer must stay valid until releaseFunc is
+// called, which happens exactly once unless MEDIA_BUFFER_FULL is returned.
+MEDIA_STATUS_T MediaPlayerClient::FeedWrapped(const guint8* pBuffer,
+                                              guint32 bufferSize,
+                                              guint64 pts,
+                                              MEDIA_DATA_CHANNEL_T esData,
+                                              GDestroyNotify releaseFunc,
+                                              gpointer userData) {
+  if (!player_ || !isLoaded_) {
+    GMP_INFO_PRINT("Invalid state, player(%p) should be loaded", player_.get());
+    if (releaseFunc)
+      releaseFunc(userData);
+    return MEDIA_NOT_READY;
+  }
+  return player_->FeedWrapped(pBuffer, bufferSize, pts, esData,
+                              releaseFunc, userData);
+}
+
+// Feeds several AUs of one channel at once. On MEDIA_BUFFER_FULL only the
+// first *accepted entries were taken and the rest should be fed again later.
+MEDIA_STATUS_T MediaPlayerClient::FeedBatch(const MEDIA_FEED_ENTRY_T* entries,
+                                            guint32 count,
+                                            MEDIA_DATA_CHANNEL_T esData,
+                                            guint32* accepted) {
+  if (!player_ || !isLoaded_) {
+    GMP_INFO_PRINT("Invalid state, player(%p) should be loaded", player_.get());
+    if (accepted)
+      *accepted = 0;
+    return MEDIA_NOT_READY;
+  }
+  return player_->FeedBatch(entries, count, esData, accepted);
+}
+
+bool MediaPlayerClient::GetFeedStats(MEDIA_DATA_CHANNEL_T esData,
+                                     MEDIA_FEED_STATS_T* stats) {
+  if (!player_ || !isLoaded_) {
+    GMP_INFO_PRINT("Invalid state, player(%p) should be loaded", player_.get());
+    return false;
+  }
+  return player_->GetFeedStats(esData, stats);
+}
+
+// Bytes this player currently holds in its appsrc/queue2 buffers.
+guint64 MediaPlayerClient::GetMemoryUsage() {
+  if (!player_ || !isLoaded_)
+    return 0;
+  return player_->GetMemoryUsage();
+}
+
 bool MediaPlayerClient::Flush() {
   GMP_DEBUG_PRINT("");
   if (!player_ || !isLoaded_) {
@@ -290,6 +371,9 @@ bool MediaPlayerClient::PushEndOfStream() {
 
 bool MediaPlayerClient::NotifyForeground() const {
   GMP_DEBUG_PRINT("");
+  if (player_)
+    player_->SetForeground(true);
+
   if (!resourceRequestor_)
     return true;
 
@@ -298,6 +382,9 @@ bool MediaPlayerClient::NotifyForeground() const {
 
 bool MediaPlayerClient::NotifyBackground() const {
   GMP_DEBUG_PRINT("");
+  if (player_)
+    player_->SetForeground(false);
+
   if (!resourceRequestor_)
     return true;
 
@@ -327,6 +414,24 @@ bool MediaPlayerClient::SetExternalContext(GMainContext *context) {
   return true;
 }
 
+// Kept for players created by a later Load.
+bool MediaPlayerClient::SetUpdateInterval(int32_t intervalMs) {
+  GMP_DEBUG_PRINT("intervalMs = %d", intervalMs);
+  updateIntervalMs_ = intervalMs > 0 ? intervalMs : 0;
+  if (!player_)
+    return true;
+  return player_->SetUpdateInterval(updateIntervalMs_);
+}
+
+bool MediaPlayerClient::SelectTrack(const std::string &type, int32_t index) {
+  GMP_DEBUG_PRINT("type = %s, index = %d", type.c_str(), index);
+  if (!player_ || !isLoaded_) {
+    GMP_INFO_PRINT("Invalid MediaPlayerClient state, player should be loaded");
+    return false;
+  }
+  return player_->SelectTrack(type, index);
+}
+
 bool MediaPlayerClient::SetPlaybackRate(const double playbackRate) {
   GMP_DEBUG_PRINT("playbackRate = %f", playbackRate);
   if (!player_ || !isLoaded_) {
@@ -39,15 +39,31 @@ class MediaPlayerClient {
 
     bool Load(const MEDIA_LOAD_DATA_T* loadData);
     bool Load(const std::string &str);
+    bool Load(const base::load_param_t &param);
     bool Unload();
+    bool Reconfigure(const MEDIA_LOAD_DATA_T* loadData);
     bool Play();
     bool Pause();
     bool Seek(int position);
+    bool SelectTrack(const std::string &type, int32_t index);
+    bool SetUpdateInterval(int32_t intervalMs);
     bool SetPlane(int planeId);
     MEDIA_STATUS_T Feed(const guint8* pBuffer,
                         guint32 bufferSize,
                         guint64 pts,
                         MEDIA_DATA_CHANNEL_T esData);
+    MEDIA_STATUS_T FeedWrapped(const guint8* pBuffer,
+                               guint32 bufferSize,
+                               guint64 pts,
+                               MEDIA_DATA_CHANNEL_T esData,
+                               GDestroyNotify releaseFunc,
+                               gpointer userData);
+    MEDIA_STATUS_T FeedBatch(const MEDIA_FEED_ENTRY_T* entries,
+                             guint32 count,
+                             MEDIA_DATA_CHANNEL_T esData,
+                             guint32* accepted);
+    bool GetFeedStats(MEDIA_DATA_CHANNEL_T esData, MEDIA_FEED_STATS_T* stats);
+    guint64 GetMemoryUsage();
     bool Flush();
     bool SetDisplayWindow(const long left,
                           const long top,
@@ -88,6 +104,7 @@ class MediaPlayerClient {
     GMainContext *playerContext_ = nullptr;
 
     bool isLoaded_ = false;
+    int32_t updateIntervalMs_ = 0;
     std::unique_ptr<gmp::resource::ResourceRequestor> resourceRequestor_;
 
     std::string appId_;
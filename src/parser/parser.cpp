@@ -18,6 +18,37 @@
 
 namespace gmp { namespace parser {
 
+namespace {
+
+bool GetPositiveTime(pbnjson::JValue value, gint64 *time) {
+  int64_t val = 0;
+  if (!value.isNumber() || value.asNumber<int64_t>(val) != CONV_OK || val <= 0)
+    return false;
+  *time = val;
+  return true;
+}
+
+// Depth-first search for a "start" key outside the known location.
+bool FindStartTime(pbnjson::JValue value, gint64 *time) {
+  if (value.isArray()) {
+    for (ssize_t i = 0; i < value.arraySize(); i++) {
+      if (FindStartTime(value[i], time))
+        return true;
+    }
+  } else if (value.isObject()) {
+    for (auto child : value.children()) {
+      if (child.first.asString() == "start" &&
+          GetPositiveTime(child.second, time))
+        return true;
+      if (FindStartTime(child.second, time))
+        return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
 Parser::Parser(const char * message) {
   pbnjson::JDomParser parser;
   if (!parser.parse(message)) {
@@ -26,5 +57,38 @@ Parser::Parser(const char * message) {
   _dom = parser.getDom();
 }
 
+// Clients pass it as options.option.transmission.playTime.start (ms).
+gint64 Parser::get_start_time(void) {
+  gint64 start_time = 0;
+  if (GetPositiveTime(
+        _dom["options"]["option"]["transmission"]["playTime"]["start"],
+        &start_time))
+    return start_time;
+
+  FindStartTime(_dom, &start_time);
+  return start_time;
+}
+
+base::load_param_t Parser::get_load_param(void) {
+  base::load_param_t param = {};
+  if (_dom["uri"].isString())
+    param.uri = _dom["uri"].asString();
+  if (_dom["id"].isString())
+    param.mediaId = _dom["id"].asString();
+
+  pbnjson::JValue option = _dom["options"]["option"];
+  if (option["appId"].isString())
+    param.appId = option["appId"].asString();
+  if (option["windowId"].isString())
+    param.windowId = option["windowId"].asString();
+  if (option["videoDisplayMode"].isString())
+    param.videoDisplayMode = option["videoDisplayMode"].asString();
+  if (option["displayPath"].isNumber())
+    param.displayPath = option["displayPath"].asNumber<int32_t>();
+
+  param.startTime = get_start_time();
+  return param;
+}
+
 }  // namespace parser
 }  // namespace gmp
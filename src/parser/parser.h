@@ -20,8 +20,8 @@
 #include <type_traits>
 #include <pbnjson.hpp>
 #include <string>
-#include <regex>
 #include <gst/gst.h>
+#include "base/types.h"
 #include "log/log.h"
 
 namespace gmp { namespace parser {
@@ -110,40 +110,14 @@ class Parser {
     return val;
   }
 
-  gint64 get_start_time(void) {
-    gint64 start_time = 0;
-//    for(auto i = _dom.children().begin(); i != _dom.children().end(); ++i) {
-    for(auto i : _dom.children()) {
-      _serialized = pbnjson::JGenerator::serialize(i.second, true);
-
-      try {
-        std::regex re("\\w+");
-        std::sregex_iterator next(_serialized.begin(), _serialized.end(), re);
-        std::sregex_iterator end;
-        while (next != end) {
-          std::smatch match = *next;
-          if (match.str() == "start") {
-            ++next;
-            match = *next;
-            start_time = std::stoll(match.str(), NULL, 10);
-            break;
-          }
-          ++next;
-        }
-      } catch (std::regex_error& e) {
-        GMP_DEBUG_PRINT("Syntax error in the regular expression");
-      }
-
-      if (start_time > 0)
-        break;
-    }
-
-    return start_time;
-  }
+  // Playback start position of a UMS load payload, 0 when absent.
+  gint64 get_start_time(void);
+
+  // Fields of a UMS load payload, missing ones are left empty.
+  base::load_param_t get_load_param(void);
 
  private:
   pbnjson::JValue _dom;
-  std::string _serialized;
 };
 
 }  // namespace parser
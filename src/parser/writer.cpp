@@ -0,0 +1,136 @@
+// Copyright (c) 2020 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstring>
+#include "writer.h"
+
+namespace gmp { namespace parser {
+
+namespace {
+
+const size_t kInitialCapacity = 256;
+
+}  // namespace
+
+Writer::Writer() : _need_comma(false) {
+  _buf.reserve(kInitialCapacity);
+}
+
+void Writer::begin_object() {
+  separate();
+  _buf += '{';
+  _need_comma = false;
+}
+
+void Writer::end_object() {
+  _buf += '}';
+  _need_comma = true;
+}
+
+void Writer::key(const char * key) {
+  separate();
+  append_escaped(key, strlen(key));
+  _buf += ':';
+  _need_comma = false;
+}
+
+void Writer::value(int64_t value) {
+  separate();
+  char digits[20];
+  size_t n = 0;
+  // negate in unsigned arithmetic, INT64_MIN has no positive counterpart
+  uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value)
+                                 : static_cast<uint64_t>(value);
+  do {
+    digits[n++] = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude);
+  if (value < 0)
+    _buf += '-';
+  while (n)
+    _buf += digits[--n];
+  _need_comma = true;
+}
+
+void Writer::value(bool value) {
+  separate();
+  _buf += value ? "true" : "false";
+  _need_comma = true;
+}
+
+void Writer::value(const std::string & value) {
+  separate();
+  append_escaped(value.data(), value.size());
+  _need_comma = true;
+}
+
+void Writer::separate() {
+  if (_need_comma)
+    _buf += ',';
+}
+
+void Writer::append_escaped(const char * str, size_t length) {
+  static const char hex[] = "0123456789abcdef";
+  _buf += '"';
+  for (size_t i = 0; i < length; i++) {
+    unsigned char c = str[i];
+    switch (c) {
+      case '"': _buf += "\\\""; break;
+      case '\\': _buf += "\\\\"; break;
+      case '\n': _buf += "\\n"; break;
+      case '\r': _buf += "\\r"; break;
+      case '\t': _buf += "\\t"; break;
+      default:
+        if (c < 0x20) {
+          _buf += "\\u00";
+          _buf += hex[c >> 4];
+          _buf += hex[c & 0xf];
+        } else {
+          _buf += c;
+        }
+        break;
+    }
+  }
+  _buf += '"';
+}
+
+void write_json(Writer & writer, int64_t value) {
+  writer.value(value);
+}
+
+// Same members as to_json(const base::buffer_range_t &) in composer.cpp.
+void write_json(Writer & writer, const base::buffer_range_t & range) {
+  writer.begin_object();
+  writer.key("beginTime");
+  writer.value(range.beginTime);
+  writer.key("endTime");
+  writer.value(range.endTime);
+  writer.key("remainingTime");
+  writer.value(range.remainingTime);
+  writer.key("percent");
+  writer.value(range.percent);
+  writer.end_object();
+}
+
+void write_json(Writer & writer, const base::media_info_t & info) {
+  writer.begin_object();
+  writer.key("mediaId");
+  writer.value(info.mediaId);
+  writer.end_object();
+}
+
+}  // namespace parser
+}  // namespace gmp
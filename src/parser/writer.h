@@ -0,0 +1,86 @@
+// Copyright (c) 2020 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef SRC_PARSER_WRITER_H_
+#define SRC_PARSER_WRITER_H_
+
+#include <cstdint>
+#include <string>
+
+#include <base/types.h>
+
+namespace gmp { namespace parser {
+
+/* Streaming JSON writer for notifications with a fixed shape.
+ * Values go straight into a buffer that keeps its capacity across
+ * documents, so a steady stream of e.g. currentTime ticks allocates
+ * nothing once the buffer has grown. */
+class Writer {
+ public:
+  Writer();
+
+  // {"key": value}, replacing the previous document.
+  template<typename T>
+  const std::string & put(const char * key, const T & value) {
+    _buf.clear();
+    _need_comma = false;
+    begin_object();
+    this->key(key);
+    write_json(*this, value);
+    end_object();
+    return _buf;
+  }
+
+  // {"key": value, "mediaId": id}
+  template<typename T>
+  const std::string & put(const char * key, const T & value,
+                          const std::string & media_id) {
+    _buf.clear();
+    _need_comma = false;
+    begin_object();
+    this->key(key);
+    write_json(*this, value);
+    this->key("mediaId");
+    this->value(media_id);
+    end_object();
+    return _buf;
+  }
+
+  const std::string & result() const { return _buf; }
+
+  void begin_object();
+  void end_object();
+  void key(const char * key);
+  void value(int64_t value);
+  void value(bool value);
+  void value(const std::string & value);
+
+ private:
+  void separate();
+  void append_escaped(const char * str, size_t length);
+
+  std::string _buf;
+  bool _need_comma;
+};
+
+void write_json(Writer & writer, int64_t value);
+void write_json(Writer & writer, const base::buffer_range_t & range);
+void write_json(Writer & writer, const base::media_info_t & info);
+
+}  // namespace parser
+}  // namespace gmp
+
+#endif  // SRC_PARSER_WRITER_H_
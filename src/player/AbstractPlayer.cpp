@@ -12,6 +12,7 @@
 
 #include "AbstractPlayer.h"
 #include "ElementFactory.h"
+#include "MemoryBudget.h"
 #include <gst/pbutils/pbutils.h>
 #include <pbnjson.hpp>
 
@@ -21,15 +22,18 @@ namespace player {
 AbstractPlayer::AbstractPlayer() :
   lsClient_(std::make_unique<gmp::LunaServiceClient>()) {
   SetGstreamerDebug();
-  SetUseAudio();
   gst_init(NULL, NULL);
   gst_pb_utils_init();
+  // pick up gst_elements.conf edits once per player, not per element
+  gmp::pf::ElementFactory::ReloadIfChanged();
+  SetUseAudio();
 }
 
 AbstractPlayer::~AbstractPlayer() {
+  UnregisterMemoryBudget();
 }
 
-bool AbstractPlayer::Load(const std::string &uri) {
+bool AbstractPlayer::Load(const base::load_param_t &param) {
   return true;
 }
 
@@ -37,6 +41,11 @@ bool AbstractPlayer::Load(const MEDIA_LOAD_DATA_T* loadData) {
   return true;
 }
 
+// Players that can't switch content in place need a full Unload/Load.
+bool AbstractPlayer::Reconfigure(const MEDIA_LOAD_DATA_T* loadData) {
+  return false;
+}
+
 bool AbstractPlayer::Unload() {
   GMP_DEBUG_PRINT("START");
 
@@ -45,14 +54,10 @@ bool AbstractPlayer::Unload() {
     return false;
   }
 
-  gst_element_set_state(pipeline_, GST_STATE_NULL);
-  gst_object_unref(GST_OBJECT(pipeline_));
-  pipeline_ = NULL;
+  ReleasePipeline();
 
-  if (currPosTimerId_) {
-    g_source_remove(currPosTimerId_);
-    currPosTimerId_ = 0;
-  }
+  StopPositionTimer();
+  positionNotifier_ = nullptr;
 
   UnloadImpl();
 
@@ -60,6 +65,12 @@ bool AbstractPlayer::Unload() {
   return true;
 }
 
+void AbstractPlayer::ReleasePipeline() {
+  gst_element_set_state(pipeline_, GST_STATE_NULL);
+  gst_object_unref(GST_OBJECT(pipeline_));
+  pipeline_ = NULL;
+}
+
 bool AbstractPlayer::UnloadImpl() {
   return true;
 }
@@ -80,6 +91,10 @@ bool AbstractPlayer::Seek(const int64_t msecond) {
   return true;
 }
 
+bool AbstractPlayer::SelectTrack(const std::string &type, int32_t index) {
+  return false;
+}
+
 bool AbstractPlayer::SetVolume(int volume) {
   return false;
 }
@@ -90,6 +105,40 @@ bool AbstractPlayer::SetPlane(int planeId) {
   return true;
 }
 
+bool AbstractPlayer::SetUpdateInterval(int32_t intervalMs) {
+  GMP_DEBUG_PRINT("SetUpdateInterval: %d ms", intervalMs);
+  std::lock_guard<std::recursive_mutex> lock(recursive_mutex_);
+  updateIntervalMs_ = intervalMs > 0 ? intervalMs : 0;
+
+  if (currPosTimerId_) {
+    StopPositionTimer();
+    StartPositionTimer();
+  }
+  return true;
+}
+
+void AbstractPlayer::SetPositionNotifier(GSourceFunc notifier,
+                                         guint defaultIntervalMs) {
+  positionNotifier_ = notifier;
+  defaultUpdateIntervalMs_ = defaultIntervalMs;
+}
+
+void AbstractPlayer::StartPositionTimer() {
+  if (currPosTimerId_ || !positionNotifier_)
+    return;
+
+  guint interval = updateIntervalMs_ ? updateIntervalMs_
+                                     : defaultUpdateIntervalMs_;
+  currPosTimerId_ = g_timeout_add(interval, positionNotifier_, this);
+}
+
+void AbstractPlayer::StopPositionTimer() {
+  if (currPosTimerId_) {
+    g_source_remove(currPosTimerId_);
+    currPosTimerId_ = 0;
+  }
+}
+
 bool AbstractPlayer::SetDisplayPath(const uint32_t display_path) {
   GMP_DEBUG_PRINT("display_path: %u", display_path);
   display_path_ = (display_path > SECONDARY_DISPLAY) ? DEFAULT_DISPLAY : display_path;
@@ -121,9 +170,85 @@ MEDIA_STATUS_T AbstractPlayer::Feed(const guint8* pBuffer,
   return MEDIA_NOT_IMPLEMENTED;
 }
 
+MEDIA_STATUS_T AbstractPlayer::FeedWrapped(const guint8* pBuffer,
+    guint32 bufferSize, guint64 pts, MEDIA_DATA_CHANNEL_T esData,
+    GDestroyNotify releaseFunc, gpointer userData) {
+  if (releaseFunc)
+    releaseFunc(userData);
+  return MEDIA_NOT_IMPLEMENTED;
+}
+
+MEDIA_STATUS_T AbstractPlayer::FeedBatch(const MEDIA_FEED_ENTRY_T* entries,
+    guint32 count, MEDIA_DATA_CHANNEL_T esData, guint32* accepted) {
+  if (accepted)
+    *accepted = 0;
+  return MEDIA_NOT_IMPLEMENTED;
+}
+
+bool AbstractPlayer::GetFeedStats(MEDIA_DATA_CHANNEL_T esData,
+                                  MEDIA_FEED_STATS_T* stats) {
+  return false;
+}
+
+void AbstractPlayer::SetForeground(bool foreground) {
+  foreground_ = foreground;
+  if (memoryBudgetId_)
+    MemoryBudget::GetInstance().SetForeground(memoryBudgetId_, foreground);
+}
+
+guint64 AbstractPlayer::GetMemoryUsage() {
+  return 0;
+}
+
+void AbstractPlayer::RegisterMemoryBudget(guint64 demand) {
+  if (memoryBudgetId_)
+    return;
+
+  memoryBudgetId_ = MemoryBudget::GetInstance().Register(demand,
+      [this](guint64 limit) { OnMemoryLimit(limit); },
+      [this]() { return GetMemoryUsage(); });
+  if (!foreground_)
+    MemoryBudget::GetInstance().SetForeground(memoryBudgetId_, false);
+}
+
+void AbstractPlayer::UnregisterMemoryBudget() {
+  if (!memoryBudgetId_)
+    return;
+
+  // No OnMemoryLimit() runs past this, only an idle may still be queued.
+  MemoryBudget::GetInstance().Unregister(memoryBudgetId_);
+  memoryBudgetId_ = 0;
+  if (memoryLimitPending_.exchange(false))
+    g_source_remove(memoryLimitSourceId_);
+}
+
+// MemoryBudget may call this on any thread, even one holding another
+// player's lock, so the limit is only stored here and applied from the
+// main loop.
+void AbstractPlayer::OnMemoryLimit(guint64 limit) {
+  memoryLimit_ = limit;
+  if (!memoryLimitPending_.exchange(true))
+    memoryLimitSourceId_ = g_idle_add(ApplyMemoryLimit, this);
+}
+
+gboolean AbstractPlayer::ApplyMemoryLimit(gpointer user_data) {
+  AbstractPlayer *player = static_cast<AbstractPlayer *>(user_data);
+  if (player->memoryLimitPending_.exchange(false)) {
+    std::lock_guard<std::recursive_mutex> lock(player->recursive_mutex_);
+    player->SetMemoryLimit(player->memoryLimit_);
+  }
+  return G_SOURCE_REMOVE;
+}
+
+void AbstractPlayer::SetMemoryLimit(guint64 limit) {
+}
+
 void AbstractPlayer::SetGstreamerDebug() {
-  pbnjson::JValue parsed
-    = pbnjson::JDomParser::fromFile("/etc/g-media-pipeline/gst_debug.conf");
+  const char *debugConf = g_getenv("GMP_GST_DEBUG_CONF");
+  if (!debugConf || !*debugConf)
+    debugConf = "/etc/g-media-pipeline/gst_debug.conf";
+
+  pbnjson::JValue parsed = pbnjson::JDomParser::fromFile(debugConf);
 
   if (!parsed.isObject()) {
     GMP_DEBUG_PRINT("Debug file parsing error. Please check gst_debug.conf");
@@ -18,6 +18,7 @@
 #ifndef SRC_PLAYER_ABSTRACTPLAYER_H_
 #define SRC_PLAYER_ABSTRACTPLAYER_H_
 
+#include <atomic>
 #include <memory>
 
 #include "Player.h"
@@ -32,18 +33,21 @@ class AbstractPlayer : public Player {
  public:
   virtual ~AbstractPlayer();
 
-  virtual bool Load(const std::string &str);
+  virtual bool Load(const base::load_param_t &param);
   virtual bool Unload();
   virtual bool UnloadImpl();
   virtual bool Play();
   virtual bool Pause();
   virtual bool SetPlayRate(const double rate);
   virtual bool Seek(const int64_t position);
+  virtual bool SelectTrack(const std::string &type, int32_t index);
   virtual bool SetVolume(int volume);
   virtual bool SetPlane(int planeId);
+  virtual bool SetUpdateInterval(int32_t intervalMs);
   virtual bool SetDisplayPath(const uint32_t display_path);
 
   virtual bool Load(const MEDIA_LOAD_DATA_T* loadData);
+  virtual bool Reconfigure(const MEDIA_LOAD_DATA_T* loadData);
   virtual void notifyFunctionUMSPolicyAction();
   virtual bool UpdateVideoResData(const gmp::base::source_info_t &sourceInfo);
   virtual void RegisterCbFunction(CALLBACK_T);
@@ -51,6 +55,16 @@ class AbstractPlayer : public Player {
   virtual bool Flush();
   virtual MEDIA_STATUS_T Feed(const guint8* pBuffer, guint32 bufferSize,
                         guint64 pts, MEDIA_DATA_CHANNEL_T esData);
+  virtual MEDIA_STATUS_T FeedWrapped(const guint8* pBuffer, guint32 bufferSize,
+                        guint64 pts, MEDIA_DATA_CHANNEL_T esData,
+                        GDestroyNotify releaseFunc, gpointer userData);
+  virtual MEDIA_STATUS_T FeedBatch(const MEDIA_FEED_ENTRY_T* entries,
+                        guint32 count, MEDIA_DATA_CHANNEL_T esData,
+                        guint32* accepted);
+  virtual bool GetFeedStats(MEDIA_DATA_CHANNEL_T esData,
+                            MEDIA_FEED_STATS_T* stats);
+  virtual void SetForeground(bool foreground);
+  virtual guint64 GetMemoryUsage();
 
   CALLBACK_T cbFunction_ = nullptr;
   virtual GstElement* GetPipeline();
@@ -66,6 +80,19 @@ class AbstractPlayer : public Player {
   bool attachSurface(bool allow_no_window = false);
   bool detachSurface();
 
+  void RegisterMemoryBudget(guint64 demand);
+  void UnregisterMemoryBudget();
+  void OnMemoryLimit(guint64 limit);
+  static gboolean ApplyMemoryLimit(gpointer user_data);
+  // Runs on the main loop with recursive_mutex_ held.
+  virtual void SetMemoryLimit(guint64 limit);
+  virtual void ReleasePipeline();
+
+  // The position timer only runs while the pipeline is PLAYING.
+  void SetPositionNotifier(GSourceFunc notifier, guint defaultIntervalMs);
+  void StartPositionTimer();
+  void StopPositionTimer();
+
   GstElement *pipeline_ = nullptr;
 
   base::source_info_t source_info_;
@@ -82,8 +109,17 @@ class AbstractPlayer : public Player {
 
   int32_t planeId_ = -1;
   guint currPosTimerId_ = 0;
+  GSourceFunc positionNotifier_ = nullptr;
+  guint defaultUpdateIntervalMs_ = 0;
+  guint updateIntervalMs_ = 0;          // 0 uses the player's default
   std::recursive_mutex recursive_mutex_;
 
+  guint32 memoryBudgetId_ = 0;
+  std::atomic<guint64> memoryLimit_ { 0 };
+  std::atomic<bool> memoryLimitPending_ { false };
+  guint memoryLimitSourceId_ = 0;
+  bool foreground_ = true;
+
   /* GAV Features */
   LSM::Connector lsm_connector_;
   std::string display_mode_ = "Default";
@@ -37,17 +37,31 @@
 #include "util/util.h"
 #include "dsi/DSIGeneratorFactory.h"
 #include "ElementFactory.h"
+#include "FeedBufferPool.h"
+#include "FeedRing.h"
+#include "PipelinePool.h"
 
 #define CURR_TIME_INTERVAL_MS    500
 #define LOAD_DONE_TIMEOUT_MS     10
 
 #define MEDIA_VIDEO_MAX      (15 * 1024 * 1024)  // 15MB
 #define MEDIA_AUDIO_MAX      (4 * 1024 * 1024)   // 4MB
+// Safety ceilings when the appsrc is limited by duration
+#define MEDIA_VIDEO_TIME_MODE_MAX  (64 * 1024 * 1024)  // 64MB
+#define MEDIA_AUDIO_TIME_MODE_MAX  (8 * 1024 * 1024)   // 8MB
 #define QUEUE_MAX_SIZE       (12 * 1024 * 1024)  // 12MB
 #define QUEUE_MAX_TIME       (10 * GST_SECOND)   // 10Secs
 
 #define BUFFER_MIN_PERCENT 50
+
+// Adaptive sizing keeps about ADAPTIVE_TARGET_TIME of data per channel.
+#define ADAPTIVE_INTERVAL_MS  2000
+#define ADAPTIVE_TARGET_TIME  (5 * GST_SECOND)
+#define ADAPTIVE_VIDEO_MIN    (2 * 1024 * 1024)  // 2MB
+#define ADAPTIVE_AUDIO_MIN    (256 * 1024)       // 256KB
 #define MEDIA_CHANNEL_MAX  2
+#define FEED_RING_SIZE     128
+#define FEED_THREAD_WAIT_MS 10
 
 namespace {
 
@@ -72,6 +86,54 @@ static void SetQueueBufferSize(GstElement *pElement,
   }
 }
 
+// Back to the element's default limits plus what gst_elements.conf sets.
+static void ResetQueueBufferSize(GstElement *pElement, const char *typeName) {
+  if (!pElement)
+    return;
+
+  for (const char *name : { "max-size-bytes", "max-size-buffers", "max-size-time" }) {
+    GParamSpec *pspec = g_object_class_find_property(G_OBJECT_GET_CLASS(pElement), name);
+    if (!pspec)
+      continue;
+    GValue value = G_VALUE_INIT;
+    g_value_init(&value, G_PARAM_SPEC_VALUE_TYPE(pspec));
+    g_param_value_set_default(pspec, &value);
+    g_object_set_property(G_OBJECT(pElement), name, &value);
+    g_value_unset(&value);
+  }
+
+  if (typeName)
+    gmp::pf::ElementFactory::SetAllproperties("custom", typeName, pElement);
+}
+
+// Moves the feed state to |to| unless it is already |to| or LOCKED.
+// Returns whether this call made the transition, so only one thread
+// notifies it.
+bool EnterFeedState(std::atomic<CUSTOM_BUFFERING_STATE_T> *state,
+                    CUSTOM_BUFFERING_STATE_T to) {
+  CUSTOM_BUFFERING_STATE_T from = *state;
+  do {
+    if (from == to || from == CUSTOM_BUFFER_LOCKED)
+      return false;
+  } while (!state->compare_exchange_weak(from, to));
+  return true;
+}
+
+// A pooled buffer holds its whole size class, not just the AU in it.
+gsize GetAllocatedSize(GstBuffer *buffer) {
+  gsize maxSize = 0;
+  gst_buffer_get_sizes(buffer, NULL, &maxSize);
+  return maxSize;
+}
+
+gsize GetAllocatedSize(GstBufferList *list) {
+  gsize size = 0;
+  guint length = gst_buffer_list_length(list);
+  for (guint i = 0; i < length; i++)
+    size += GetAllocatedSize(gst_buffer_list_get(list, i));
+  return size;
+}
+
 }  // namespace
 
 namespace gmp {
@@ -101,6 +163,19 @@ BufferPlayer::~BufferPlayer() {
   Unload();
 }
 
+bool BufferPlayer::Unload() {
+  // The pusher thread uses the appsrc elements, stop it before teardown.
+  StopFeedThread();
+  UnregisterMemoryBudget();
+
+  if (adaptiveTimerId_) {
+    g_source_remove(adaptiveTimerId_);
+    adaptiveTimerId_ = 0;
+  }
+
+  return AbstractPlayer::Unload();
+}
+
 bool BufferPlayer::UnloadImpl() {
   GMP_INFO_PRINT("START");
 
@@ -345,6 +420,7 @@ bool BufferPlayer::SetVolume(int volume) {
 
 bool BufferPlayer::Load(const MEDIA_LOAD_DATA_T* loadData) {
   GMP_INFO_PRINT("loadData(%p)", loadData);
+  gint64 loadStart = g_get_monotonic_time();
 
   if (!UpdateLoadData(loadData))
     return false;
@@ -369,17 +445,27 @@ bool BufferPlayer::Load(const MEDIA_LOAD_DATA_T* loadData) {
     return false;
   }
 
-  if (!attachSurface(loadData_->videoCodec == GMP_VIDEO_CODEC_NONE)) {
+  if (!attachSurface(loadData_->videoCodec == GMP_VIDEO_CODEC_NONE ||
+                     pf::ElementFactory::GetAllowNoWindow())) {
     GMP_DEBUG_PRINT("attachSurface() failed");
     return false;
   }
 
-  if (!CreatePipeline()) {
+  poolable_ = IsPipelinePoolable();
+  pooledLoad_ = poolable_ && AcquirePooledPipeline();
+  if (!pooledLoad_ && !CreatePipeline()) {
     GMP_DEBUG_PRINT("CreatePipeline Failed");
     return false;
   }
   gst_segment_init(&segment_, GST_FORMAT_TIME);
 
+  guint64 demand = 0;
+  if (videoSrcInfo_)
+    demand += videoSrcInfo_->channelMaxByte;
+  if (audioSrcInfo_)
+    demand += audioSrcInfo_->channelMaxByte;
+  RegisterMemoryBudget(demand);
+
   if (!PauseInternal()) {
     GMP_INFO_PRINT("Failed to pause !!!");
     return false;
@@ -410,13 +496,225 @@ bool BufferPlayer::Load(const MEDIA_LOAD_DATA_T* loadData) {
       return false;
     }
   }
-  currPosTimerId_ = g_timeout_add(CURR_TIME_INTERVAL_MS,
-                                  (GSourceFunc)NotifyCurrentTime, this);
+  SetPositionNotifier((GSourceFunc)NotifyCurrentTime, CURR_TIME_INTERVAL_MS);
+
+  // In duration mode appsrc already scales with the content.
+  if (!loadData_->bufferMaxTime)
+    adaptiveTimerId_ = g_timeout_add(ADAPTIVE_INTERVAL_MS,
+                                     (GSourceFunc)AdaptBufferSize, this);
+
+  if (loadData_->asyncFeed)
+    StartFeedThread();
 
   feedPossible_ = true;
+
+  gint64 loadTime = g_get_monotonic_time() - loadStart;
+  GMP_INFO_PRINT("Load took %" G_GINT64_FORMAT " us (%s pipeline)",
+                 loadTime, pooledLoad_ ? "pooled" : "new");
+  PipelinePool &pool = PipelinePool::GetInstance();
+  if (pool.IsEnabled()) {
+    pool.RecordLoad(pooledLoad_, loadTime);
+    pool.Dump();
+  }
   return true;
 }
 
+// Switches a loaded pipeline to new content. Only the parser and decoder
+// of a channel whose codec changed are replaced, the appsrcs, sinks and
+// the surface stay attached. Returns false when a full Load is needed.
+bool BufferPlayer::Reconfigure(const MEDIA_LOAD_DATA_T* loadData) {
+  guint64 demand = 0;
+  {
+    std::lock_guard<std::recursive_mutex> lock(recursive_mutex_);
+    if (!ReconfigurePipeline(loadData, &demand))
+      return false;
+  }
+
+  // Unregister waits for budget callbacks in flight, keep the player
+  // lock out of it.
+  UnregisterMemoryBudget();
+  RegisterMemoryBudget(demand);
+  return true;
+}
+
+bool BufferPlayer::ReconfigurePipeline(const MEDIA_LOAD_DATA_T* loadData,
+                                       guint64* demand) {
+  GMP_INFO_PRINT("loadData(%p)", loadData);
+  gint64 reconfigureStart = g_get_monotonic_time();
+
+  if (!CanReconfigure(loadData))
+    return false;
+
+  bool videoChanged = loadData->videoCodec != loadData_->videoCodec;
+  bool audioChanged = loadData->audioCodec != loadData_->audioCodec;
+
+  feedPossible_ = false;
+  StopFeedThread();
+  DiscardQueuedFeed();
+
+  if (gst_element_set_state(pipeline_, GST_STATE_READY) ==
+      GST_STATE_CHANGE_FAILURE) {
+    GMP_INFO_PRINT("Failed to set pipeline to READY");
+    poolable_ = false;
+    return false;
+  }
+
+  if (!UpdateLoadData(loadData)) {
+    poolable_ = false;
+    return false;
+  }
+
+  if ((videoChanged && !RebuildVideoDecodeChain()) ||
+      (audioChanged && !RebuildAudioDecodeChain())) {
+    GMP_INFO_PRINT("Failed to rebuild decode chain");
+    poolable_ = false;
+    return false;
+  }
+
+  if (videoChanged || audioChanged) {
+    source_info_ = GetSourceInfo(loadData);
+
+    ACQUIRE_RESOURCE_INFO_T resource_info;
+    resource_info.sourceInfo = &source_info_;
+    resource_info.displayMode = const_cast<char*>(display_mode_.c_str());
+    resource_info.result = false;
+
+    if (cbFunction_)
+      cbFunction_(NOTIFY_ACQUIRE_RESOURCE, display_path_, nullptr,
+                  static_cast<void*>(&resource_info));
+
+    if (!resource_info.result) {
+      GMP_DEBUG_PRINT("resouce acquire fail!");
+      poolable_ = false;
+      return false;
+    }
+  }
+
+  for (MEDIA_SRC_T* pAppSrcInfo : { videoSrcInfo_.get(), audioSrcInfo_.get() }) {
+    if (pAppSrcInfo)
+      gst_app_src_set_caps(GST_APP_SRC(pAppSrcInfo->pSrcElement), NULL);
+  }
+  ResetChannels();
+
+  *demand = 0;
+  if (videoSrcInfo_)
+    *demand += videoSrcInfo_->channelMaxByte;
+  if (audioSrcInfo_)
+    *demand += audioSrcInfo_->channelMaxByte;
+
+  gst_segment_init(&segment_, GST_FORMAT_TIME);
+  currentPts_ = 0;
+  recEndOfStream_ = false;
+  load_complete_ = false;
+  seeking_ = false;
+
+  if (!PauseInternal()) {
+    GMP_INFO_PRINT("Failed to pause !!!");
+    poolable_ = false;
+    return false;
+  }
+
+  currentState_ = LOADING_STATE;
+
+  if (loadData_->ptsToDecode > 0) {
+    GMP_DEBUG_PRINT("Seek to (%" G_GINT64_FORMAT ") in Reconfigure",
+      loadData_->ptsToDecode);
+    if (!gst_element_seek(pipeline_, 1.0, GST_FORMAT_TIME,
+                          GstSeekFlags(GST_SEEK_FLAG_FLUSH |
+                                       GST_SEEK_FLAG_KEY_UNIT),
+                          GST_SEEK_TYPE_SET, loadData_->ptsToDecode,
+                          GST_SEEK_TYPE_NONE, 0)) {
+      GMP_INFO_PRINT("pipeline seek failed");
+      poolable_ = false;
+      return false;
+    }
+  }
+
+  if (loadData_->bufferMaxTime && adaptiveTimerId_) {
+    g_source_remove(adaptiveTimerId_);
+    adaptiveTimerId_ = 0;
+  } else if (!loadData_->bufferMaxTime && !adaptiveTimerId_) {
+    adaptiveTimerId_ = g_timeout_add(ADAPTIVE_INTERVAL_MS,
+                                     (GSourceFunc)AdaptBufferSize, this);
+  }
+
+  if (loadData_->asyncFeed)
+    StartFeedThread();
+
+  feedPossible_ = true;
+
+  GMP_INFO_PRINT("Reconfigure took %" G_GINT64_FORMAT " us (video %s, audio %s)",
+                 g_get_monotonic_time() - reconfigureStart,
+                 videoChanged ? "rebuilt" : "kept",
+                 audioChanged ? "rebuilt" : "kept");
+  return true;
+}
+
+// Anything that changes the shape of the pipeline rather than the decoder
+// of a channel needs a full Load.
+bool BufferPlayer::CanReconfigure(const MEDIA_LOAD_DATA_T* loadData) const {
+  if (!pipeline_ || !loadData_ || !loadData)
+    return false;
+
+  if ((loadData->videoCodec == GMP_VIDEO_CODEC_NONE) !=
+      (loadData_->videoCodec == GMP_VIDEO_CODEC_NONE) ||
+      (loadData->audioCodec == GMP_AUDIO_CODEC_NONE) !=
+      (loadData_->audioCodec == GMP_AUDIO_CODEC_NONE)) {
+    GMP_DEBUG_PRINT("channel layout changed");
+    return false;
+  }
+
+  if (loadData->liveStream || loadData_->liveStream ||
+      loadData->svpVersion || loadData_->svpVersion || inputDumpFileName ||
+      !g_strcmp0(loadData->format, "raw") ||
+      !g_strcmp0(loadData_->format, "raw")) {
+    GMP_DEBUG_PRINT("live, svp, dump or raw pipeline can't be reconfigured");
+    return false;
+  }
+
+  return true;
+}
+
+bool BufferPlayer::RebuildVideoDecodeChain() {
+  GMP_DEBUG_PRINT("Rebuild video decode chain for codec[%d]",
+                  loadData_->videoCodec);
+  GstElement *downstream = videoQueue_ ? videoQueue_ :
+                           vConverter_ ? vConverter_ : videoSink_;
+
+  RemoveElement(&videoParser_);
+  RemoveElement(&videoDecoder_);
+  RemoveElement(&videoPostProc_);
+
+  linkedElement_ = videoPQueue_;
+  if (!AddVideoParser() || !AddVideoDecoderElement())
+    return false;
+
+  return gst_element_link(linkedElement_, downstream);
+}
+
+bool BufferPlayer::RebuildAudioDecodeChain() {
+  GMP_DEBUG_PRINT("Rebuild audio decode chain for codec[%d]",
+                  loadData_->audioCodec);
+  RemoveElement(&audioParser_);
+  RemoveElement(&audioDecoder_);
+
+  linkedElement_ = audioPQueue_;
+  if (!AddAudioParser() || !AddAudioDecoderElement())
+    return false;
+
+  return gst_element_link(linkedElement_, audioConverter_);
+}
+
+// Removing from the bin unlinks the pads and drops the last reference.
+void BufferPlayer::RemoveElement(GstElement** element) {
+  if (!*element)
+    return;
+
+  gst_element_set_state(*element, GST_STATE_NULL);
+  gst_bin_remove(GST_BIN(pipeline_), *element);
+  *element = nullptr;
+}
+
 bool BufferPlayer::PushEndOfStream() {
   GMP_DEBUG_PRINT("PushEndOfStream");
 
@@ -428,6 +726,16 @@ bool BufferPlayer::PushEndOfStream() {
 
   recEndOfStream_ = true;
 
+  if (feedThread_.joinable()) {
+    // EOS has to follow the AUs still waiting in the rings.
+    if (audioSrcInfo_)
+      audioSrcInfo_->eosPending = true;
+    if (videoSrcInfo_)
+      videoSrcInfo_->eosPending = true;
+    WakeFeedThread();
+    return true;
+  }
+
   if (audioSrcInfo_ && audioSrcInfo_->pSrcElement) {
     if (GST_FLOW_OK != gst_app_src_end_of_stream(
             GST_APP_SRC(audioSrcInfo_->pSrcElement)))
@@ -462,6 +770,7 @@ bool BufferPlayer::Flush() {
     audioSrcInfo_->needFeedData = CUSTOM_BUFFER_LOCKED;
   }
 
+  DiscardQueuedFeed();
   recEndOfStream_ = false;
 
   // flush pipeline
@@ -479,7 +788,212 @@ bool BufferPlayer::Flush() {
 
 MEDIA_STATUS_T BufferPlayer::Feed(const guint8* pBuffer,
     guint32 bufferSize, guint64 pts, MEDIA_DATA_CHANNEL_T esData) {
+  MEDIA_SRC_T* pAppSrcInfo = nullptr;
+  MEDIA_STATUS_T status = CheckFeed(bufferSize, esData, &pAppSrcInfo);
+  if (status != MEDIA_OK)
+    return status;
+
+  GstBuffer *appSrcBuffer = CreateFeedBuffer(pAppSrcInfo, pBuffer, bufferSize);
+  if (!appSrcBuffer) {
+    GMP_DEBUG_PRINT("can't get app src buffer");
+    return MEDIA_ERROR;
+  }
+
+  return PushFeedBuffer(pAppSrcInfo, appSrcBuffer, pts, esData);
+}
+
+// Unless MEDIA_BUFFER_FULL is returned, releaseFunc is called exactly once:
+// either right away on failure or when the pipeline drops the last reference.
+MEDIA_STATUS_T BufferPlayer::FeedWrapped(const guint8* pBuffer,
+    guint32 bufferSize, guint64 pts, MEDIA_DATA_CHANNEL_T esData,
+    GDestroyNotify releaseFunc, gpointer userData) {
+  MEDIA_SRC_T* pAppSrcInfo = nullptr;
+  MEDIA_STATUS_T status = CheckFeed(bufferSize, esData, &pAppSrcInfo);
+  if (status != MEDIA_OK) {
+    if (status != MEDIA_BUFFER_FULL && releaseFunc)
+      releaseFunc(userData);
+    return status;
+  }
+
+  GstBuffer *appSrcBuffer = gst_buffer_new_wrapped_full(
+      GST_MEMORY_FLAG_READONLY, const_cast<guint8 *>(pBuffer), bufferSize,
+      0, bufferSize, userData, releaseFunc);
+  if (!appSrcBuffer) {
+    GMP_DEBUG_PRINT("can't wrap app src buffer");
+    if (releaseFunc)
+      releaseFunc(userData);
+    return MEDIA_ERROR;
+  }
 
+  return PushFeedBuffer(pAppSrcInfo, appSrcBuffer, pts, esData);
+}
+
+// Only one capacity check is made for the whole batch, the longest prefix
+// that fits is pushed as a single GstBufferList, or queued on the feed
+// ring when that has room for it.
+MEDIA_STATUS_T BufferPlayer::FeedBatch(const MEDIA_FEED_ENTRY_T* entries,
+    guint32 count, MEDIA_DATA_CHANNEL_T esData, guint32* accepted) {
+  if (accepted)
+    *accepted = 0;
+
+  if (!entries || count == 0 || !accepted) {
+    GMP_INFO_PRINT("Invalid batch (entries:%p, count:%u)", entries, count);
+    return MEDIA_INVALID_PARAMS;
+  }
+
+  for (guint32 i = 0; i < count; i++) {
+    if (!entries[i].pBuffer || entries[i].bufferSize == 0) {
+      GMP_INFO_PRINT("Invalid batch entry[%u]", i);
+      return MEDIA_INVALID_PARAMS;
+    }
+  }
+
+  MEDIA_SRC_T* pAppSrcInfo = nullptr;
+  MEDIA_STATUS_T status = GetFeedSrcInfo(esData, &pAppSrcInfo);
+  if (status != MEDIA_OK)
+    return status;
+
+  if (IsTimeLimitReached(pAppSrcInfo)) {
+    pAppSrcInfo->needFeedData = CUSTOM_BUFFER_FULL;
+    GMP_INFO_PRINT("Feed is not Possible!!!");
+    return MEDIA_BUFFER_FULL;
+  }
+
+  guint32 acceptCount = count;
+  if (pAppSrcInfo->needFeedData == CUSTOM_BUFFER_FULL) {
+    guint64 availableSize = GetAvailableBytes(pAppSrcInfo);
+    guint64 acceptSize = 0;
+    for (acceptCount = 0; acceptCount < count; acceptCount++) {
+      if (acceptSize + entries[acceptCount].bufferSize > availableSize)
+        break;
+      acceptSize += entries[acceptCount].bufferSize;
+    }
+  }
+  if (pAppSrcInfo->feedRing) {
+    guint32 ringSpace = pAppSrcInfo->feedRing->GetCapacity() -
+                        pAppSrcInfo->feedRing->GetDepth();
+    acceptCount = MIN(acceptCount, ringSpace);
+  }
+  if (acceptCount == 0) {
+    GMP_INFO_PRINT("Feed is not Possible!!!");
+    return MEDIA_BUFFER_FULL;
+  }
+  pAppSrcInfo->needFeedData = CUSTOM_BUFFER_FEED;
+
+  if (pAppSrcInfo->feedRing) {
+    for (guint32 i = 0; i < acceptCount; i++) {
+      GstBuffer *appSrcBuffer = CreateFeedBuffer(pAppSrcInfo,
+          entries[i].pBuffer, entries[i].bufferSize);
+      if (!appSrcBuffer) {
+        GMP_DEBUG_PRINT("can't get app src buffer");
+        WakeFeedThread();
+        return MEDIA_ERROR;
+      }
+      MEDIA_STATUS_T status = PushFeedBuffer(pAppSrcInfo, appSrcBuffer,
+                                             entries[i].pts, esData);
+      if (status != MEDIA_OK)
+        return status;
+      (*accepted)++;
+    }
+    return acceptCount < count ? MEDIA_BUFFER_FULL : MEDIA_OK;
+  }
+
+  GstBufferList *bufferList = gst_buffer_list_new_sized(acceptCount);
+  guint64 pushedSize = 0;
+  for (guint32 i = 0; i < acceptCount; i++) {
+    GstBuffer *appSrcBuffer = CreateFeedBuffer(pAppSrcInfo,
+        entries[i].pBuffer, entries[i].bufferSize);
+    if (!appSrcBuffer) {
+      GMP_DEBUG_PRINT("can't get app src buffer");
+      gst_buffer_list_unref(bufferList);
+      return MEDIA_ERROR;
+    }
+    GST_BUFFER_TIMESTAMP(appSrcBuffer) = entries[i].pts;
+    gst_buffer_list_add(bufferList, appSrcBuffer);
+    pushedSize += entries[i].bufferSize;
+  }
+
+  gsize allocatedSize = GetAllocatedSize(bufferList);
+  pAppSrcInfo->queuedBytes += allocatedSize;
+  UpdateTailPts(pAppSrcInfo, entries[acceptCount - 1].pts);
+  GstFlowReturn gstReturn = gst_app_src_push_buffer_list(
+      GST_APP_SRC(pAppSrcInfo->pSrcElement), bufferList);
+  if (gstReturn < GST_FLOW_OK) {
+    GMP_INFO_PRINT("gst_app_src_push_buffer_list errCode[ %d ]", gstReturn);
+    ReleaseQueuedBytes(pAppSrcInfo, allocatedSize);
+    return MEDIA_ERROR;
+  }
+
+  pAppSrcInfo->totalFeed += pushedSize;
+  *accepted = acceptCount;
+
+  if (acceptCount < count) {
+    GMP_DEBUG_PRINT("[%s] accepted %u of %u entries",
+                    pAppSrcInfo->elementName.c_str(), acceptCount, count);
+    return MEDIA_BUFFER_FULL;
+  }
+  return MEDIA_OK;
+}
+
+bool BufferPlayer::GetFeedStats(MEDIA_DATA_CHANNEL_T esData,
+                                MEDIA_FEED_STATS_T* stats) {
+  if (!stats)
+    return false;
+
+  MEDIA_SRC_T* pAppSrcInfo = nullptr;
+  if (esData == MEDIA_DATA_CH_A)
+    pAppSrcInfo = videoSrcInfo_.get();
+  else if (esData == MEDIA_DATA_CH_B)
+    pAppSrcInfo = audioSrcInfo_.get();
+
+  if (!pAppSrcInfo)
+    return false;
+
+  stats->totalFeed = pAppSrcInfo->totalFeed;
+  stats->poolHits = 0;
+  stats->poolMisses = 0;
+  if (pAppSrcInfo->feedPool) {
+    stats->poolHits = pAppSrcInfo->feedPool->GetHitCount();
+    stats->poolMisses = pAppSrcInfo->feedPool->GetMissCount();
+  }
+  stats->bufferMaxByte = pAppSrcInfo->bufferMaxByte;
+  stats->byteRate = pAppSrcInfo->byteRate;
+  stats->ringDepth = 0;
+  stats->ringCapacity = 0;
+  if (pAppSrcInfo->feedRing) {
+    stats->ringDepth = pAppSrcInfo->feedRing->GetDepth();
+    stats->ringCapacity = pAppSrcInfo->feedRing->GetCapacity();
+  }
+  return true;
+}
+
+MEDIA_STATUS_T BufferPlayer::CheckFeed(guint32 bufferSize,
+    MEDIA_DATA_CHANNEL_T esData, MEDIA_SRC_T** ppAppSrcInfo) {
+  if (bufferSize == 0) {
+    GMP_INFO_PRINT("Possible bufferSize (%d) is Zeror!!!", bufferSize);
+    return MEDIA_ERROR;
+  }
+
+  MEDIA_SRC_T* pAppSrcInfo = nullptr;
+  MEDIA_STATUS_T status = GetFeedSrcInfo(esData, &pAppSrcInfo);
+  if (status != MEDIA_OK)
+    return status;
+
+  // Single producer, the ring can only drain between here and the push.
+  if (pAppSrcInfo->feedRing && pAppSrcInfo->feedRing->IsFull())
+    return MEDIA_BUFFER_FULL;
+
+  if (!IsFeedPossible(pAppSrcInfo, bufferSize)) {
+     GMP_INFO_PRINT("Feed is not Possible!!!");
+     return MEDIA_BUFFER_FULL;
+  }
+
+  *ppAppSrcInfo = pAppSrcInfo;
+  return MEDIA_OK;
+}
+
+MEDIA_STATUS_T BufferPlayer::GetFeedSrcInfo(MEDIA_DATA_CHANNEL_T esData,
+                                            MEDIA_SRC_T** ppAppSrcInfo) {
   if (!pipeline_) {
     GMP_DEBUG_PRINT("Pipeline is null");
     return MEDIA_ERROR;
@@ -500,49 +1014,62 @@ MEDIA_STATUS_T BufferPlayer::Feed(const guint8* pBuffer,
     return MEDIA_ERROR;
   }
 
-  if (!pAppSrcInfo) {
+  if (!pAppSrcInfo || !pAppSrcInfo->pSrcElement) {
     GMP_INFO_PRINT("App SRC not found !!!");
     return MEDIA_ERROR;
   }
 
-  if (!pAppSrcInfo->pSrcElement || bufferSize == 0) {
-    GMP_INFO_PRINT("Possible bufferSize (%d) is Zeror!!!", bufferSize);
-    return MEDIA_ERROR;
-  }
-
-  if (!IsFeedPossible(pAppSrcInfo, bufferSize)) {
-     GMP_INFO_PRINT("Feed is not Possible!!!");
-     return MEDIA_BUFFER_FULL;
-  }
-
   if (recEndOfStream_) {
     GMP_INFO_PRINT("Already EOS received !!!");
     return MEDIA_ERROR;
   }
 
+  *ppAppSrcInfo = pAppSrcInfo;
+  return MEDIA_OK;
+}
+
+GstBuffer* BufferPlayer::CreateFeedBuffer(MEDIA_SRC_T* pAppSrcInfo,
+    const guint8* pBuffer, guint32 bufferSize) {
+  if (pAppSrcInfo->feedPool)
+    return pAppSrcInfo->feedPool->Acquire(pBuffer, bufferSize);
+
   guint8 *feedBuffer = (guint8 *)g_malloc(bufferSize);
   if (feedBuffer == NULL) {
     GMP_DEBUG_PRINT("memory allocation error!!!!!");
-    return MEDIA_ERROR;
+    return nullptr;
   }
-
   memcpy(feedBuffer, pBuffer, bufferSize);
+  return gst_buffer_new_wrapped(feedBuffer, bufferSize);
+}
 
-  GstBuffer *appSrcBuffer = gst_buffer_new_wrapped(feedBuffer, bufferSize);
-  if (!appSrcBuffer) {
-    g_free(feedBuffer);
-    GMP_DEBUG_PRINT("can't get app src buffer");
-    return MEDIA_ERROR;
-  }
+MEDIA_STATUS_T BufferPlayer::PushFeedBuffer(MEDIA_SRC_T* pAppSrcInfo,
+    GstBuffer* appSrcBuffer, guint64 pts, MEDIA_DATA_CHANNEL_T esData) {
+  gsize bufferSize = gst_buffer_get_size(appSrcBuffer);
 
   if (esData != MEDIA_DATA_CH_NONE) {// raw data
     GST_BUFFER_TIMESTAMP(appSrcBuffer) = pts;
   }
 
+  if (pAppSrcInfo->feedRing) {
+    if (!pAppSrcInfo->feedRing->Push(appSrcBuffer, feedSeq_)) {
+      GMP_INFO_PRINT("[%s] feed ring is full", pAppSrcInfo->elementName.c_str());
+      gst_buffer_unref(appSrcBuffer);
+      return MEDIA_ERROR;
+    }
+    pAppSrcInfo->totalFeed += bufferSize;
+    WakeFeedThread();
+    return MEDIA_OK;
+  }
+
+  // Counted before the push, the src pad probe may see the buffer first.
+  gsize allocatedSize = GetAllocatedSize(appSrcBuffer);
+  pAppSrcInfo->queuedBytes += allocatedSize;
+  UpdateTailPts(pAppSrcInfo, GST_BUFFER_PTS(appSrcBuffer));
   GstFlowReturn gstReturn = gst_app_src_push_buffer(
       GST_APP_SRC(pAppSrcInfo->pSrcElement), appSrcBuffer);
   if (gstReturn < GST_FLOW_OK) {
     GMP_INFO_PRINT("gst_app_src_push_buffer errCode[ %d ]", gstReturn);
+    ReleaseQueuedBytes(pAppSrcInfo, allocatedSize);
     return MEDIA_ERROR;
   }
 
@@ -585,6 +1112,8 @@ gboolean BufferPlayer::HandleBusMessage(
                      pError->message, pDebug ? pDebug : "null");
       g_error_free(pError);
       g_free(pDebug);
+      // an element that failed once isn't handed to the next Load
+      player->poolable_ = false;
       if (player->cbFunction_)
         player->cbFunction_(NOTIFY_ERROR, 0, nullptr, nullptr);
       break;
@@ -671,37 +1200,14 @@ GstBusSyncReply BufferPlayer::HandleSyncBusMessage(
       if (g_strcmp0 (type, waylandDisplayHandleContextType) != 0) {
         break;
       }
-      GMP_DEBUG_PRINT("Set a wayland display handle : %p", connector->getDisplay());
-      GstContext *context = gst_context_new(waylandDisplayHandleContextType, TRUE);
-      gst_structure_set(gst_context_writable_structure (context),
-          "handle", G_TYPE_POINTER, connector->getDisplay(), nullptr);
-      gst_element_set_context(GST_ELEMENT(GST_MESSAGE_SRC(message)), context);
+      SetDisplayContext(GST_ELEMENT(GST_MESSAGE_SRC(message)), connector);
       goto drop;
     }
     case GST_MESSAGE_ELEMENT:{
       if (!gst_is_video_overlay_prepare_window_handle_message(message)) {
         break;
       }
-      GMP_DEBUG_PRINT("Set wayland window handle : %p", connector->getSurface());
-      if (connector->getSurface()) {
-        GstVideoOverlay *videoOverlay = GST_VIDEO_OVERLAY(GST_MESSAGE_SRC(message));
-        gst_video_overlay_set_window_handle(videoOverlay,
-                                            (guintptr)(connector->getSurface()));
-
-        gint video_disp_height = 0;
-        gint video_disp_width = 0;
-        connector->getVideoSize(video_disp_width, video_disp_height);
-        if (video_disp_width && video_disp_height) {
-          gint display_x = (1920 - video_disp_width) / 2;
-          gint display_y = (1080 - video_disp_height) / 2;
-          GMP_DEBUG_PRINT("Set render rectangle :(%d, %d, %d, %d)",
-                          display_x, display_y, video_disp_width, video_disp_height);
-          gst_video_overlay_set_render_rectangle(videoOverlay,
-              display_x, display_y, video_disp_width, video_disp_height);
-
-          gst_video_overlay_expose(videoOverlay);
-        }
-      }
+      SetWindowHandle(GST_VIDEO_OVERLAY(GST_MESSAGE_SRC(message)), connector);
       goto drop;
     }
     default:
@@ -715,6 +1221,153 @@ drop:
   return GST_BUS_DROP;
 }
 
+void BufferPlayer::SetDisplayContext(GstElement *element,
+                                     LSM::Connector *connector) {
+  GMP_DEBUG_PRINT("Set a wayland display handle : %p", connector->getDisplay());
+  GstContext *context = gst_context_new(waylandDisplayHandleContextType, TRUE);
+  gst_structure_set(gst_context_writable_structure (context),
+      "handle", G_TYPE_POINTER, connector->getDisplay(), nullptr);
+  gst_element_set_context(element, context);
+  gst_context_unref(context);
+}
+
+void BufferPlayer::SetWindowHandle(GstVideoOverlay *videoOverlay,
+                                   LSM::Connector *connector) {
+  GMP_DEBUG_PRINT("Set wayland window handle : %p", connector->getSurface());
+  if (!connector->getSurface())
+    return;
+
+  gst_video_overlay_set_window_handle(videoOverlay,
+                                      (guintptr)(connector->getSurface()));
+
+  gint video_disp_height = 0;
+  gint video_disp_width = 0;
+  connector->getVideoSize(video_disp_width, video_disp_height);
+  if (video_disp_width && video_disp_height) {
+    gint display_x = (1920 - video_disp_width) / 2;
+    gint display_y = (1080 - video_disp_height) / 2;
+    GMP_DEBUG_PRINT("Set render rectangle :(%d, %d, %d, %d)",
+                    display_x, display_y, video_disp_width, video_disp_height);
+    gst_video_overlay_set_render_rectangle(videoOverlay,
+        display_x, display_y, video_disp_width, video_disp_height);
+
+    gst_video_overlay_expose(videoOverlay);
+  }
+}
+
+
+gboolean BufferPlayer::AdaptBufferSize(gpointer user_data) {
+  BufferPlayer *player = static_cast<BufferPlayer*>(user_data);
+  std::lock_guard<std::recursive_mutex> lock(player->recursive_mutex_);
+
+  if (!player->pipeline_ || player->seeking_)
+    return true;
+
+  player->AdaptChannelBufferSize(player->videoSrcInfo_.get(),
+                                 ADAPTIVE_VIDEO_MIN, player->videoPQueue_);
+  player->AdaptChannelBufferSize(player->audioSrcInfo_.get(),
+                                 ADAPTIVE_AUDIO_MIN, player->audioPQueue_);
+  return true;
+}
+
+// Measures the fed bytes per PTS second since the last call and resizes the
+// channel to hold ADAPTIVE_TARGET_TIME of it, within [min, channel max].
+void BufferPlayer::AdaptChannelBufferSize(MEDIA_SRC_T* pAppSrcInfo,
+                                          guint minBufferSize,
+                                          GstElement* parserQueue) {
+  if (!pAppSrcInfo || !pAppSrcInfo->pSrcElement)
+    return;
+
+  guint64 totalFeed = pAppSrcInfo->totalFeed;
+  guint64 tailPts = pAppSrcInfo->tailPts;
+  guint64 lastFeed = pAppSrcInfo->rateLastFeed;
+  guint64 lastPts = pAppSrcInfo->rateLastPts;
+  pAppSrcInfo->rateLastFeed = totalFeed;
+  pAppSrcInfo->rateLastPts = tailPts;
+
+  // Restart the window after a flush or seek reset the counters.
+  if (!GST_CLOCK_TIME_IS_VALID(tailPts) || !GST_CLOCK_TIME_IS_VALID(lastPts) ||
+      tailPts <= lastPts || totalFeed <= lastFeed)
+    return;
+
+  guint64 rate = gst_util_uint64_scale(totalFeed - lastFeed, GST_SECOND,
+                                       tailPts - lastPts);
+  // Smooth over I-frame bursts.
+  pAppSrcInfo->byteRate = pAppSrcInfo->byteRate ?
+                          (pAppSrcInfo->byteRate * 3 + rate) / 4 : rate;
+
+  guint64 target = gst_util_uint64_scale(pAppSrcInfo->byteRate,
+                                         ADAPTIVE_TARGET_TIME, GST_SECOND);
+  target = CLAMP(target, (guint64)minBufferSize,
+                 (guint64)pAppSrcInfo->channelMaxByte);
+
+  // Ignore changes under 10% to avoid touching the elements every period.
+  guint current = pAppSrcInfo->adaptiveMaxByte;
+  if (target * 10 > (guint64)current * 9 && target * 10 < (guint64)current * 11)
+    return;
+
+  GMP_INFO_PRINT("[%s] rate = %" G_GUINT64_FORMAT " B/s, adaptive size %u -> %"
+                 G_GUINT64_FORMAT, pAppSrcInfo->elementName.c_str(),
+                 pAppSrcInfo->byteRate, current, target);
+  pAppSrcInfo->adaptiveMaxByte = (guint)target;
+  ApplyChannelBufferSize(pAppSrcInfo, parserQueue);
+}
+
+// The effective size is the smaller of the adaptive size and the share of
+// the memory budget. It applies to the compressed side only, the queues
+// after the decoder keep their configured limits.
+void BufferPlayer::ApplyChannelBufferSize(MEDIA_SRC_T* pAppSrcInfo,
+                                          GstElement* parserQueue) {
+  if (!pAppSrcInfo || !pAppSrcInfo->pSrcElement)
+    return;
+
+  guint size = MIN(pAppSrcInfo->adaptiveMaxByte,
+                   (guint)pAppSrcInfo->budgetMaxByte);
+  if (size == pAppSrcInfo->bufferMaxByte)
+    return;
+
+  GMP_INFO_PRINT("[%s] max-bytes %u -> %u", pAppSrcInfo->elementName.c_str(),
+                 (guint)pAppSrcInfo->bufferMaxByte, size);
+  pAppSrcInfo->bufferMaxByte = size;
+  g_object_set(G_OBJECT(pAppSrcInfo->pSrcElement),
+               "max-bytes", (guint64)size, NULL);
+  if (parserQueue)
+    SetQueueBufferSize(parserQueue, size, 3);
+}
+
+// The budget limit is split between the channels in proportion to their
+// default sizes.
+void BufferPlayer::SetMemoryLimit(guint64 limit) {
+  std::lock_guard<std::recursive_mutex> lock(recursive_mutex_);
+
+  guint64 total = 0;
+  if (videoSrcInfo_)
+    total += videoSrcInfo_->channelMaxByte;
+  if (audioSrcInfo_)
+    total += audioSrcInfo_->channelMaxByte;
+  if (!total)
+    return;
+
+  if (videoSrcInfo_) {
+    videoSrcInfo_->budgetMaxByte = (guint)gst_util_uint64_scale(
+        limit, videoSrcInfo_->channelMaxByte, total);
+    ApplyChannelBufferSize(videoSrcInfo_.get(), videoPQueue_);
+  }
+  if (audioSrcInfo_) {
+    audioSrcInfo_->budgetMaxByte = (guint)gst_util_uint64_scale(
+        limit, audioSrcInfo_->channelMaxByte, total);
+    ApplyChannelBufferSize(audioSrcInfo_.get(), audioPQueue_);
+  }
+}
+
+guint64 BufferPlayer::GetMemoryUsage() {
+  guint64 usage = 0;
+  if (videoSrcInfo_)
+    usage += videoSrcInfo_->queuedBytes;
+  if (audioSrcInfo_)
+    usage += audioSrcInfo_->queuedBytes;
+  return usage;
+}
 
 gboolean BufferPlayer::NotifyCurrentTime(gpointer user_data) {
   BufferPlayer *player = static_cast<BufferPlayer*>(user_data);
@@ -859,7 +1512,15 @@ bool BufferPlayer::AddAudioSourceElement() {
     return false;
   }
 
-  SetAppSrcProperties(audioSrcInfo_.get(), MEDIA_AUDIO_MAX);
+  guint64 audioMaxByte = loadData_->bufferMaxTime ?
+                         MEDIA_AUDIO_TIME_MODE_MAX : MEDIA_AUDIO_MAX;
+  SetAppSrcProperties(audioSrcInfo_.get(), audioMaxByte,
+                      loadData_->bufferMaxTime);
+  ConnectAppSrcSignals(audioSrcInfo_.get());
+  AddAppSrcProbe(audioSrcInfo_.get());
+  audioSrcInfo_->feedPool = std::make_shared<FeedBufferPool>(audioMaxByte);
+  if (loadData_->asyncFeed)
+    audioSrcInfo_->feedRing = std::make_shared<FeedRing>(FEED_RING_SIZE);
 
   gst_bin_add(GST_BIN(pipeline_), audioSrcInfo_->pSrcElement);
   linkedElement_ = audioSrcInfo_->pSrcElement;
@@ -881,6 +1542,10 @@ bool BufferPlayer::AddAudioParserElement() {
     return false;
   }
 
+  return AddAudioParser();
+}
+
+bool BufferPlayer::AddAudioParser() {
   switch (loadData_->audioCodec) {
     case GMP_AUDIO_CODEC_AC3:
     case GMP_AUDIO_CODEC_EAC3:
@@ -1013,7 +1678,15 @@ bool BufferPlayer::AddVideoSourceElement() {
     return false;
   }
 
-  SetAppSrcProperties(videoSrcInfo_.get(), MEDIA_VIDEO_MAX);
+  guint64 videoMaxByte = loadData_->bufferMaxTime ?
+                         MEDIA_VIDEO_TIME_MODE_MAX : MEDIA_VIDEO_MAX;
+  SetAppSrcProperties(videoSrcInfo_.get(), videoMaxByte,
+                      loadData_->bufferMaxTime);
+  ConnectAppSrcSignals(videoSrcInfo_.get());
+  AddAppSrcProbe(videoSrcInfo_.get());
+  videoSrcInfo_->feedPool = std::make_shared<FeedBufferPool>(videoMaxByte);
+  if (loadData_->asyncFeed)
+    videoSrcInfo_->feedRing = std::make_shared<FeedRing>(FEED_RING_SIZE);
 
   if (loadData_->liveStream)
     g_object_set(videoSrcInfo_->pSrcElement, "is-live", true, NULL);
@@ -1042,6 +1715,10 @@ bool BufferPlayer::AddVideoParserElement() {
     return true;
   }
 
+  return AddVideoParser();
+}
+
+bool BufferPlayer::AddVideoParser() {
   switch (loadData_->videoCodec) {
     case GMP_VIDEO_CODEC_VC1:
       GMP_DEBUG_PRINT("VC1 Parser");
@@ -1254,6 +1931,8 @@ bool BufferPlayer::ConnectBusCallback() {
     GMP_DEBUG_PRINT("Got pipeline bus. busHandler_ [%p]", busHandler_);
   }
 
+  // a pooled pipeline comes back with a flushing bus
+  gst_bus_set_flushing(busHandler_, false);
   gst_bus_add_signal_watch(busHandler_);
   gSigBusAsync_ = g_signal_connect(busHandler_, "message",
                                    G_CALLBACK(BufferPlayer::HandleBusMessage),
@@ -1278,8 +1957,10 @@ bool BufferPlayer::DisconnectBusCallback() {
       g_signal_handler_disconnect(busHandler_, gSigBusAsync_);
 
     gst_bus_remove_signal_watch(busHandler_);
+    gst_bus_set_sync_handler(busHandler_, NULL, NULL, NULL);
     gst_object_unref(busHandler_);
     busHandler_ = NULL;
+    gSigBusAsync_ = 0;
   }
 
   GMP_INFO_PRINT("END");
@@ -1326,6 +2007,7 @@ bool BufferPlayer::SeekInternal(const int64_t msecond) {
     audioSrcInfo_->needFeedData = CUSTOM_BUFFER_LOCKED;
   }
 
+  DiscardQueuedFeed();
   recEndOfStream_ = false;
   feedPossible_ = false;
   if (!gst_element_seek(pipeline_, play_rate_, GST_FORMAT_TIME,
@@ -1344,26 +2026,167 @@ bool BufferPlayer::SeekInternal(const int64_t msecond) {
   return true;
 }
 
-bool BufferPlayer::IsBufferAvailable(MEDIA_SRC_T* pAppSrcInfo,
-                                     guint64 newBufferSize) {
-  guint64 maxBufferSize = 0, currBufferSize = 0, availableSize = 0;
-  bool bBufferAvailable = false;
+void BufferPlayer::StartFeedThread() {
+  if (feedThread_.joinable())
+    return;
+
+  GMP_DEBUG_PRINT("Start feed thread");
+  feedThreadStop_ = false;
+  feedThreadWakeup_ = false;
+  feedThread_ = std::thread(&BufferPlayer::FeedThreadLoop, this);
+}
+
+void BufferPlayer::StopFeedThread() {
+  if (!feedThread_.joinable())
+    return;
+
+  GMP_DEBUG_PRINT("Stop feed thread");
+  {
+    std::lock_guard<std::mutex> lock(feedThreadLock_);
+    feedThreadStop_ = true;
+  }
+  feedThreadCond_.notify_one();
+  feedThread_.join();
+}
+
+void BufferPlayer::WakeFeedThread() {
+  {
+    std::lock_guard<std::mutex> lock(feedThreadLock_);
+    feedThreadWakeup_ = true;
+  }
+  feedThreadCond_.notify_one();
+}
+
+// Waits for new AUs, or polls while appsrc is full until need-data wakes us.
+void BufferPlayer::FeedThreadLoop() {
+  std::unique_lock<std::mutex> lock(feedThreadLock_);
+  while (!feedThreadStop_) {
+    feedThreadCond_.wait_for(lock,
+        std::chrono::milliseconds(FEED_THREAD_WAIT_MS),
+        [this] { return feedThreadStop_ || feedThreadWakeup_; });
+    if (feedThreadStop_)
+      break;
+    feedThreadWakeup_ = false;
+
+    lock.unlock();
+    bool progress = true;
+    while (progress && !feedThreadStop_) {
+      progress = DrainFeedRing(videoSrcInfo_.get());
+      progress = DrainFeedRing(audioSrcInfo_.get()) || progress;
+    }
+    lock.lock();
+  }
+}
+
+bool BufferPlayer::DrainFeedRing(MEDIA_SRC_T* pAppSrcInfo) {
+  if (!pAppSrcInfo || !pAppSrcInfo->feedRing)
+    return false;
+
+  bool progress = false;
+  GstBuffer *appSrcBuffer = nullptr;
+  guint32 seq = 0;
+  while (pAppSrcInfo->feedRing->Front(&appSrcBuffer, &seq)) {
+    std::lock_guard<std::mutex> lock(feedPushLock_);
+    if (seq != feedSeq_) {
+      // queued before the last flush or seek
+      gst_buffer_unref(appSrcBuffer);
+      pAppSrcInfo->feedRing->Pop();
+      progress = true;
+      continue;
+    }
+
+    if (pAppSrcInfo->queuedBytes >= pAppSrcInfo->bufferMaxByte ||
+        IsTimeLimitReached(pAppSrcInfo))
+      break;
 
-  if (pAppSrcInfo->pSrcElement != NULL) {
-    g_object_get(G_OBJECT(pAppSrcInfo->pSrcElement),
-                 "current-level-bytes", &currBufferSize, NULL);
-    g_object_get(G_OBJECT(pAppSrcInfo->pSrcElement),
-                 "max-bytes", &maxBufferSize, NULL);
-    GMP_DEBUG_PRINT("[%s], maxBufferSize = %" G_GUINT64_FORMAT
-                    ", currBufferSize = %" G_GUINT64_FORMAT,
-                    pAppSrcInfo->elementName.c_str(),
-                    maxBufferSize, currBufferSize);
+    gsize allocatedSize = GetAllocatedSize(appSrcBuffer);
+    pAppSrcInfo->queuedBytes += allocatedSize;
+    UpdateTailPts(pAppSrcInfo, GST_BUFFER_PTS(appSrcBuffer));
+    pAppSrcInfo->feedRing->Pop();
+    GstFlowReturn gstReturn = gst_app_src_push_buffer(
+        GST_APP_SRC(pAppSrcInfo->pSrcElement), appSrcBuffer);
+    if (gstReturn < GST_FLOW_OK) {
+      GMP_INFO_PRINT("gst_app_src_push_buffer errCode[ %d ]", gstReturn);
+      ReleaseQueuedBytes(pAppSrcInfo, allocatedSize);
+    }
+    progress = true;
+  }
+
+  if (pAppSrcInfo->feedRing->GetDepth() == 0 &&
+      pAppSrcInfo->eosPending.exchange(false)) {
+    GMP_DEBUG_PRINT("[%s] push pending EOS", pAppSrcInfo->elementName.c_str());
+    gst_app_src_end_of_stream(GST_APP_SRC(pAppSrcInfo->pSrcElement));
   }
 
+  return progress;
+}
+
+// Anything still in the rings belongs to the old segment, the pusher
+// thread drops it when it sees the new sequence number.
+void BufferPlayer::DiscardQueuedFeed() {
+  std::lock_guard<std::mutex> lock(feedPushLock_);
+  feedSeq_++;
+  if (videoSrcInfo_)
+    videoSrcInfo_->eosPending = false;
+  if (audioSrcInfo_)
+    audioSrcInfo_->eosPending = false;
+}
+
+// Duration between the last pushed PTS and the last PTS that left appsrc.
+// Zero while either is unknown, the byte limit still applies then.
+guint64 BufferPlayer::GetQueuedTime(MEDIA_SRC_T* pAppSrcInfo) {
+  guint64 headPts = pAppSrcInfo->headPts;
+  guint64 tailPts = pAppSrcInfo->tailPts;
+
+  if (!GST_CLOCK_TIME_IS_VALID(headPts) || !GST_CLOCK_TIME_IS_VALID(tailPts) ||
+      tailPts <= headPts)
+    return 0;
+  return tailPts - headPts;
+}
+
+void BufferPlayer::UpdateTailPts(MEDIA_SRC_T* pAppSrcInfo, guint64 pts) {
+  if (!GST_CLOCK_TIME_IS_VALID(pts))
+    return;
+
+  // Until a buffer left appsrc the first pushed PTS is the head.
+  guint64 none = GST_CLOCK_TIME_NONE;
+  pAppSrcInfo->headPts.compare_exchange_strong(none, pts);
+  pAppSrcInfo->tailPts = pts;
+}
+
+bool BufferPlayer::IsTimeLimitReached(MEDIA_SRC_T* pAppSrcInfo) {
+  if (pAppSrcInfo->bufferMaxTime == 0)
+    return false;
+
+  guint64 queuedTime = GetQueuedTime(pAppSrcInfo);
+  if (queuedTime < pAppSrcInfo->bufferMaxTime)
+    return false;
+
+  GMP_DEBUG_PRINT("[%s] queuedTime = %" GST_TIME_FORMAT " reached limit",
+                  pAppSrcInfo->elementName.c_str(), GST_TIME_ARGS(queuedTime));
+  return true;
+}
+
+// Uses the cached appsrc limit and the probe driven counter so the feed
+// path never takes the GObject property or appsrc locks.
+guint64 BufferPlayer::GetAvailableBytes(MEDIA_SRC_T* pAppSrcInfo) {
+  guint64 maxBufferSize = pAppSrcInfo->bufferMaxByte;
+  guint64 currBufferSize = pAppSrcInfo->queuedBytes;
+
+  GMP_DEBUG_PRINT("[%s], maxBufferSize = %" G_GUINT64_FORMAT
+                  ", currBufferSize = %" G_GUINT64_FORMAT,
+                  pAppSrcInfo->elementName.c_str(),
+                  maxBufferSize, currBufferSize);
+
   if (maxBufferSize <= currBufferSize)
-    availableSize = 0;
-  else
-    availableSize = maxBufferSize - currBufferSize;
+    return 0;
+  return maxBufferSize - currBufferSize;
+}
+
+bool BufferPlayer::IsBufferAvailable(MEDIA_SRC_T* pAppSrcInfo,
+                                     guint64 newBufferSize) {
+  bool bBufferAvailable = false;
+  guint64 availableSize = GetAvailableBytes(pAppSrcInfo);
 
   GMP_DEBUG_PRINT("[%s], availableSize = %" G_GUINT64_FORMAT
                   ", newBufferSize = %" G_GUINT64_FORMAT,
@@ -1381,6 +2204,11 @@ bool BufferPlayer::IsBufferAvailable(MEDIA_SRC_T* pAppSrcInfo,
 
 bool BufferPlayer::IsFeedPossible(MEDIA_SRC_T* pAppSrcInfo,
                                   guint64 newBufferSize) {
+  if (IsTimeLimitReached(pAppSrcInfo)) {
+    pAppSrcInfo->needFeedData = CUSTOM_BUFFER_FULL;
+    return false;
+  }
+
   if (pAppSrcInfo->needFeedData == CUSTOM_BUFFER_FULL) {
     if (IsBufferAvailable(pAppSrcInfo, newBufferSize)) {
       pAppSrcInfo->needFeedData = CUSTOM_BUFFER_FEED;
@@ -1414,6 +2242,11 @@ void BufferPlayer::HandleBusStateMsg(GstMessage *pMessage)  {
       GST_DEBUG_BIN_TO_DOT_FILE_WITH_TS(GST_BIN (pipeline_),
             GST_DEBUG_GRAPH_SHOW_ALL, dump_name.c_str());
     }
+
+    if (newState == GST_STATE_PLAYING)
+      StartPositionTimer();
+    else if (oldState == GST_STATE_PLAYING)
+      StopPositionTimer();
   }
 
   GstElement* gstElement = GST_ELEMENT(pMessage->src);
@@ -1467,7 +2300,7 @@ void BufferPlayer::HandleBusAsyncMsg() {
     if (recEndOfStream_)
       return;
 
-    if (videoSrcInfo_ && videoSrcInfo_->needFeedData != CUSTOM_BUFFER_LOW)
+    if (videoSrcInfo_)
       videoSrcInfo_->needFeedData = CUSTOM_BUFFER_LOW;
   } else if (seeking_) {
     seeking_ = false;
@@ -1555,6 +2388,8 @@ bool BufferPlayer::UpdateLoadData(const MEDIA_LOAD_DATA_T* loadData) {
     loadData_->displayPath = loadData->displayPath;
     loadData_->liveStream = loadData->liveStream;
     loadData_->sampleFormat = loadData->sampleFormat;
+    loadData_->asyncFeed = loadData->asyncFeed;
+    loadData_->bufferMaxTime = loadData->bufferMaxTime;
     return true;
   }
   return false;
@@ -1615,19 +2450,56 @@ void BufferPlayer::EnoughData(GstElement *gstAppSrc, gpointer userData) {
     pAppSrcInfo = player->audioSrcInfo_.get();
   }
 
-  if (pAppSrcInfo) {
-    if ((pAppSrcInfo->needFeedData != CUSTOM_BUFFER_FULL) &&
-        (pAppSrcInfo->needFeedData != CUSTOM_BUFFER_LOCKED)) {
-      guint64 currBufferSize = 0;
-      g_object_get(G_OBJECT(gstAppSrc),
-                 "current-level-bytes", &currBufferSize, NULL);
-      GMP_DEBUG_PRINT("currBufferSize [ %" G_GUINT64_FORMAT " ]", currBufferSize);
+  if (pAppSrcInfo &&
+      EnterFeedState(&pAppSrcInfo->needFeedData, CUSTOM_BUFFER_FULL)) {
+    GMP_DEBUG_PRINT("currBufferSize [ %" G_GUINT64_FORMAT " ]",
+                    (guint64)pAppSrcInfo->queuedBytes);
 
-      pAppSrcInfo->needFeedData = CUSTOM_BUFFER_FULL;
+    if (pAppSrcInfo == player->videoSrcInfo_.get() && player->cbFunction_)
+      player->cbFunction_(NOTIFY_BUFFER_FULL, dataChType, nullptr, nullptr);
+  }
+}
 
-      if (pAppSrcInfo == player->videoSrcInfo_.get() && player->cbFunction_)
-        player->cbFunction_(NOTIFY_BUFFER_FULL, dataChType, nullptr, nullptr);
-    }
+// Called on the appsrc streaming thread once the queue drops below
+// min-percent. Producers waiting on NOTIFY_BUFFER_NEED can feed again.
+void BufferPlayer::NeedData(GstElement *gstAppSrc, guint length,
+                            gpointer userData) {
+  if (!gstAppSrc)
+    return;
+
+  BufferPlayer *player = reinterpret_cast <BufferPlayer*>(userData);
+
+  MEDIA_DATA_CHANNEL_T dataChType = MEDIA_DATA_CH_NONE;
+  MEDIA_SRC_T* pAppSrcInfo = nullptr;
+  if (IsElementName(gstAppSrc, "video-app-es")) {
+    dataChType = MEDIA_DATA_CH_A;
+    pAppSrcInfo = player->videoSrcInfo_.get();
+  } else  if(IsElementName(gstAppSrc, "audio-app-es")) {
+    dataChType = MEDIA_DATA_CH_B;
+    pAppSrcInfo = player->audioSrcInfo_.get();
+  }
+
+  if (player->feedThread_.joinable())
+    player->WakeFeedThread();
+
+  // Only notify on the transition, appsrc keeps emitting while it is low.
+  if (!pAppSrcInfo || player->recEndOfStream_ ||
+      player->IsTimeLimitReached(pAppSrcInfo) ||
+      !EnterFeedState(&pAppSrcInfo->needFeedData, CUSTOM_BUFFER_LOW))
+    return;
+
+  guint64 currBufferSize = pAppSrcInfo->queuedBytes;
+  GMP_DEBUG_PRINT("Appsrc signal : NeedData [%s] currBufferSize [ %"
+                  G_GUINT64_FORMAT " ]", pAppSrcInfo->elementName.c_str(),
+                  currBufferSize);
+
+  // udata is replaced by the client's user data, the level goes in strValue.
+  if (player->cbFunction_) {
+    gmp::parser::Composer composer;
+    composer.put("channel", static_cast<int32_t>(dataChType));
+    composer.put("level", static_cast<int64_t>(currBufferSize));
+    player->cbFunction_(NOTIFY_BUFFER_NEED, dataChType,
+                        composer.result().c_str(), nullptr);
   }
 }
 
@@ -1637,6 +2509,44 @@ gboolean BufferPlayer::SeekData(GstElement *gstAppSrc, guint64 position,
   return true;
 }
 
+GstPadProbeReturn BufferPlayer::AppSrcProbe(GstPad *pad, GstPadProbeInfo *info,
+                                            gpointer userData) {
+  MEDIA_SRC_T *pAppSrcInfo = reinterpret_cast<MEDIA_SRC_T*>(userData);
+
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER) {
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    ReleaseQueuedBytes(pAppSrcInfo, GetAllocatedSize(buffer));
+    if (GST_BUFFER_PTS_IS_VALID(buffer))
+      pAppSrcInfo->headPts = GST_BUFFER_PTS(buffer);
+  } else if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST(info);
+    ReleaseQueuedBytes(pAppSrcInfo, GetAllocatedSize(list));
+    guint length = gst_buffer_list_length(list);
+    if (length > 0) {
+      GstBuffer *buffer = gst_buffer_list_get(list, length - 1);
+      if (GST_BUFFER_PTS_IS_VALID(buffer))
+        pAppSrcInfo->headPts = GST_BUFFER_PTS(buffer);
+    }
+  } else if (info->type & GST_PAD_PROBE_TYPE_EVENT_FLUSH) {
+    // appsrc drops everything it queued on flush
+    if (GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info)) == GST_EVENT_FLUSH_STOP) {
+      pAppSrcInfo->queuedBytes = 0;
+      pAppSrcInfo->headPts = GST_CLOCK_TIME_NONE;
+      pAppSrcInfo->tailPts = GST_CLOCK_TIME_NONE;
+    }
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+void BufferPlayer::ReleaseQueuedBytes(MEDIA_SRC_T* pAppSrcInfo, guint64 size) {
+  // Saturate at zero, a flush may already have cleared the counter.
+  guint64 queued = pAppSrcInfo->queuedBytes;
+  while (!pAppSrcInfo->queuedBytes.compare_exchange_weak(
+             queued, queued > size ? queued - size : 0)) {
+  }
+}
+
 void BufferPlayer::SetDecoderSpecificInfomation() {
   GMP_DEBUG_PRINT("");
 
@@ -1733,7 +2643,8 @@ base::source_info_t BufferPlayer::GetSourceInfo(
 }
 
 void BufferPlayer::SetAppSrcProperties(MEDIA_SRC_T* pAppSrcInfo,
-                                       guint64 bufferMaxLevel) {
+                                       guint64 bufferMaxLevel,
+                                       guint64 bufferMaxTime) {
   guint32 bufferMinPercent = BUFFER_MIN_PERCENT;
 
   gst_util_set_object_arg(G_OBJECT(pAppSrcInfo->pSrcElement),
@@ -1745,12 +2656,26 @@ void BufferPlayer::SetAppSrcProperties(MEDIA_SRC_T* pAppSrcInfo,
                "min-percent", bufferMinPercent,
                NULL);
 
-  g_signal_connect(reinterpret_cast<GstAppSrc*>(pAppSrcInfo->pSrcElement),
-                   "enough-data", G_CALLBACK(EnoughData), this);
-  g_signal_connect(reinterpret_cast<GstAppSrc*>(pAppSrcInfo->pSrcElement),
-                   "seek-data", G_CALLBACK(SeekData), this);
+  // appsrc only knows max-time since 1.20, older versions rely on the
+  // PTS span tracked by AppSrcProbe.
+  if (g_object_class_find_property(
+          G_OBJECT_GET_CLASS(pAppSrcInfo->pSrcElement), "max-time")) {
+    g_object_set(G_OBJECT(pAppSrcInfo->pSrcElement),
+                 "max-time", bufferMaxTime, NULL);
+  }
+  pAppSrcInfo->bufferMaxTime = bufferMaxTime;
+  pAppSrcInfo->headPts = GST_CLOCK_TIME_NONE;
+  pAppSrcInfo->tailPts = GST_CLOCK_TIME_NONE;
+
+  pAppSrcInfo->queuedBytes = 0;
 
   pAppSrcInfo->bufferMaxByte = bufferMaxLevel;
+  pAppSrcInfo->channelMaxByte = bufferMaxLevel;
+  pAppSrcInfo->adaptiveMaxByte = bufferMaxLevel;
+  pAppSrcInfo->budgetMaxByte = bufferMaxLevel;
+  pAppSrcInfo->rateLastFeed = 0;
+  pAppSrcInfo->rateLastPts = GST_CLOCK_TIME_NONE;
+  pAppSrcInfo->byteRate = 0;
   pAppSrcInfo->bufferMinPercent = bufferMinPercent;
 
   gchar * srcReadName = NULL;
@@ -1763,6 +2688,179 @@ void BufferPlayer::SetAppSrcProperties(MEDIA_SRC_T* pAppSrcInfo,
   }
 }
 
+// The signals carry this player, they are dropped when the pipeline goes
+// back to the pool.
+void BufferPlayer::ConnectAppSrcSignals(MEDIA_SRC_T* pAppSrcInfo) {
+  g_signal_connect(reinterpret_cast<GstAppSrc*>(pAppSrcInfo->pSrcElement),
+                   "enough-data", G_CALLBACK(EnoughData), this);
+  g_signal_connect(reinterpret_cast<GstAppSrc*>(pAppSrcInfo->pSrcElement),
+                   "need-data", G_CALLBACK(NeedData), this);
+  g_signal_connect(reinterpret_cast<GstAppSrc*>(pAppSrcInfo->pSrcElement),
+                   "seek-data", G_CALLBACK(SeekData), this);
+}
+
+// The probe only carries the MEDIA_SRC_T, which stays with the pipeline.
+void BufferPlayer::AddAppSrcProbe(MEDIA_SRC_T* pAppSrcInfo) {
+  GstPad *srcPad = gst_element_get_static_pad(pAppSrcInfo->pSrcElement, "src");
+  if (srcPad) {
+    gst_pad_add_probe(srcPad, (GstPadProbeType)(GST_PAD_PROBE_TYPE_BUFFER |
+                      GST_PAD_PROBE_TYPE_BUFFER_LIST |
+                      GST_PAD_PROBE_TYPE_EVENT_FLUSH),
+                      AppSrcProbe, pAppSrcInfo, NULL);
+    gst_object_unref(srcPad);
+  }
+}
+
+bool BufferPlayer::IsPipelinePoolable() const {
+  // Live, SVP, raw AAC and dump pipelines differ by more than the pool key.
+  return PipelinePool::GetInstance().IsEnabled() &&
+         !loadData_->liveStream && !loadData_->svpVersion &&
+         !inputDumpFileName && g_strcmp0(loadData_->format, "raw");
+}
+
+bool BufferPlayer::AcquirePooledPipeline() {
+  std::unique_ptr<PipelinePool::Entry> entry =
+      PipelinePool::GetInstance().Acquire(PipelinePool::MakeKey(
+          loadData_->videoCodec, loadData_->audioCodec, display_path_,
+          window_id_));
+  if (!entry)
+    return false;
+
+  GMP_INFO_PRINT("reuse pooled pipeline %p", entry->pipeline);
+  pipeline_ = entry->pipeline;
+  videoSrcInfo_ = entry->videoSrcInfo;
+  audioSrcInfo_ = entry->audioSrcInfo;
+  videoPQueue_ = entry->videoPQueue;
+  videoParser_ = entry->videoParser;
+  videoDecoder_ = entry->videoDecoder;
+  videoPostProc_ = entry->videoPostProc;
+  videoQueue_ = entry->videoQueue;
+  vConverter_ = entry->vConverter;
+  videoSink_ = entry->videoSink;
+  audioPQueue_ = entry->audioPQueue;
+  audioParser_ = entry->audioParser;
+  audioDecoder_ = entry->audioDecoder;
+  audioConverter_ = entry->audioConverter;
+  audioQueue_ = entry->audioQueue;
+  audioSink_ = entry->audioSink;
+
+  ConnectBusCallback();
+  if (videoSrcInfo_)
+    ConnectAppSrcSignals(videoSrcInfo_.get());
+  if (audioSrcInfo_)
+    ConnectAppSrcSignals(audioSrcInfo_.get());
+
+  ApplyDisplay();
+  ResetChannels();
+  return true;
+}
+
+// The sink of a pooled pipeline still holds the display and surface of the
+// player that used it last, give it the ones of this player's connector.
+void BufferPlayer::ApplyDisplay() {
+  if (!videoSink_)
+    return;
+
+  SetDisplayContext(videoSink_, &lsm_connector_);
+
+  GstElement *overlay = GST_IS_BIN(videoSink_) ?
+      gst_bin_get_by_interface(GST_BIN(videoSink_), GST_TYPE_VIDEO_OVERLAY) :
+      GST_IS_VIDEO_OVERLAY(videoSink_) ? GST_ELEMENT(gst_object_ref(videoSink_)) :
+      nullptr;
+  if (overlay) {
+    SetWindowHandle(GST_VIDEO_OVERLAY(overlay), &lsm_connector_);
+    gst_object_unref(overlay);
+  }
+}
+
+// Per Load reset of the appsrcs and queues of a pipeline that is reused.
+void BufferPlayer::ResetChannels() {
+  if (videoSrcInfo_) {
+    ReuseAppSrc(videoSrcInfo_.get(), loadData_->bufferMaxTime ?
+                MEDIA_VIDEO_TIME_MODE_MAX : MEDIA_VIDEO_MAX);
+    SetQueueBufferSize(videoPQueue_, 0, 3);
+    ResetQueueBufferSize(videoQueue_, "video-queue");
+  }
+  if (audioSrcInfo_) {
+    ReuseAppSrc(audioSrcInfo_.get(), loadData_->bufferMaxTime ?
+                MEDIA_AUDIO_TIME_MODE_MAX : MEDIA_AUDIO_MAX);
+    SetQueueBufferSize(audioPQueue_, 0, 3);
+    ResetQueueBufferSize(audioQueue_, nullptr);
+  }
+
+  SetDecoderSpecificInfomation();
+}
+
+// Per Load setup of an appsrc that comes from the pool or a reconfigure.
+void BufferPlayer::ReuseAppSrc(MEDIA_SRC_T* pAppSrcInfo,
+                               guint64 bufferMaxLevel) {
+  pAppSrcInfo->needFeedData = CUSTOM_BUFFER_FEED;
+  pAppSrcInfo->totalFeed = 0;
+  pAppSrcInfo->eosPending = false;
+
+  SetAppSrcProperties(pAppSrcInfo, bufferMaxLevel, loadData_->bufferMaxTime);
+
+  pAppSrcInfo->feedPool = std::make_shared<FeedBufferPool>(bufferMaxLevel);
+  if (loadData_->asyncFeed)
+    pAppSrcInfo->feedRing = std::make_shared<FeedRing>(FEED_RING_SIZE);
+  else
+    pAppSrcInfo->feedRing.reset();
+}
+
+// Unload parks a reusable pipeline instead of destroying it. It stays in
+// READY only where the decoders give their hardware back in READY, the
+// resources are released right after this, otherwise it goes to NULL.
+void BufferPlayer::ReleasePipeline() {
+  PipelinePool &pool = PipelinePool::GetInstance();
+  GstState parkState = pf::ElementFactory::GetPipelinePoolReady() ?
+      GST_STATE_READY : GST_STATE_NULL;
+  if (!poolable_ || !loadData_ || !pool.IsEnabled() ||
+      gst_element_set_state(pipeline_, parkState) ==
+          GST_STATE_CHANGE_FAILURE) {
+    AbstractPlayer::ReleasePipeline();
+    return;
+  }
+
+  std::unique_ptr<PipelinePool::Entry> entry(new PipelinePool::Entry);
+  entry->pipeline = pipeline_;
+  entry->videoSrcInfo = videoSrcInfo_;
+  entry->audioSrcInfo = audioSrcInfo_;
+  entry->videoPQueue = videoPQueue_;
+  entry->videoParser = videoParser_;
+  entry->videoDecoder = videoDecoder_;
+  entry->videoPostProc = videoPostProc_;
+  entry->videoQueue = videoQueue_;
+  entry->vConverter = vConverter_;
+  entry->videoSink = videoSink_;
+  entry->audioPQueue = audioPQueue_;
+  entry->audioParser = audioParser_;
+  entry->audioDecoder = audioDecoder_;
+  entry->audioConverter = audioConverter_;
+  entry->audioQueue = audioQueue_;
+  entry->audioSink = audioSink_;
+
+  for (MEDIA_SRC_T* pAppSrcInfo : { videoSrcInfo_.get(), audioSrcInfo_.get() }) {
+    if (!pAppSrcInfo)
+      continue;
+    g_signal_handlers_disconnect_by_data(pAppSrcInfo->pSrcElement, this);
+    gst_app_src_set_caps(GST_APP_SRC(pAppSrcInfo->pSrcElement), NULL);
+    pAppSrcInfo->feedRing.reset();
+  }
+  // before the pipeline is visible to another player
+  DisconnectBusCallback();
+
+  if (!pool.Release(PipelinePool::MakeKey(loadData_->videoCodec,
+                                          loadData_->audioCodec,
+                                          display_path_, window_id_),
+                    std::move(entry))) {
+    AbstractPlayer::ReleasePipeline();
+    return;
+  }
+
+  GMP_INFO_PRINT("pipeline %p returned to the pool", pipeline_);
+  pipeline_ = NULL;
+}
+
 void BufferPlayer::SetDebugDumpFileName() {
   inputDumpFileName = getenv("GST_DUMP_FILENAME");
 }
@@ -1775,6 +2873,8 @@ void BufferPlayer::PrintLoadData(const MEDIA_LOAD_DATA_T* loadData) {
   GMP_DEBUG_PRINT("width[%d], height[%d], frameRate[%d]",
                   loadData->width, loadData->height, loadData->frameRate);
   GMP_DEBUG_PRINT("ptsToDecode[%" G_GINT64_FORMAT"]", loadData->ptsToDecode);
+  GMP_DEBUG_PRINT("asyncFeed[%d], bufferMaxTime[%" GST_TIME_FORMAT "]",
+                  loadData->asyncFeed, GST_TIME_ARGS(loadData->bufferMaxTime));
   GMP_DEBUG_PRINT("extraData[%p], extraSize[%d]", loadData->extraData, loadData->extraSize);
   GMP_DEBUG_PRINT("windowId[%s]", loadData->windowId);
   GMP_DEBUG_PRINT("-----------------------------------------");
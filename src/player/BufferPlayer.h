@@ -17,6 +17,12 @@
 #ifndef SRC_PLAYER_BUFFER_PLAYER_H_
 #define SRC_PLAYER_BUFFER_PLAYER_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <gst/video/videooverlay.h>
+
 #include "AbstractPlayer.h"
 #include "PlayerTypes.h"
 #include "mediaplayerclient/MediaPlayerClient.h"
@@ -31,6 +37,8 @@ class BufferPlayer : public AbstractPlayer {
     ~BufferPlayer();
 
     bool Load(const MEDIA_LOAD_DATA_T* loadData) override;
+    bool Reconfigure(const MEDIA_LOAD_DATA_T* loadData) override;
+    bool Unload() override;
     bool UnloadImpl() override;
     bool Play() override;
     bool Pause() override;
@@ -43,12 +51,27 @@ class BufferPlayer : public AbstractPlayer {
     bool Flush() override;
     MEDIA_STATUS_T Feed(const guint8* pBuffer, guint32 bufferSize,
                         guint64 pts, MEDIA_DATA_CHANNEL_T esData) override;
+    MEDIA_STATUS_T FeedWrapped(const guint8* pBuffer, guint32 bufferSize,
+                        guint64 pts, MEDIA_DATA_CHANNEL_T esData,
+                        GDestroyNotify releaseFunc, gpointer userData) override;
+    MEDIA_STATUS_T FeedBatch(const MEDIA_FEED_ENTRY_T* entries, guint32 count,
+                             MEDIA_DATA_CHANNEL_T esData,
+                             guint32* accepted) override;
+    bool GetFeedStats(MEDIA_DATA_CHANNEL_T esData,
+                      MEDIA_FEED_STATS_T* stats) override;
+    guint64 GetMemoryUsage() override;
+
+    static gboolean AdaptBufferSize(gpointer user_data);
 
     static gboolean HandleBusMessage(GstBus* bus,
                                      GstMessage* message,
                                      gpointer user_data);
     static GstBusSyncReply HandleSyncBusMessage(GstBus * bus,
                                      GstMessage * msg, gpointer data);
+    static void SetDisplayContext(GstElement *element,
+                                  LSM::Connector *connector);
+    static void SetWindowHandle(GstVideoOverlay *videoOverlay,
+                                LSM::Connector *connector);
 
     static gboolean NotifyCurrentTime(gpointer user_data);
 
@@ -62,6 +85,7 @@ class BufferPlayer : public AbstractPlayer {
     /* for audio */
     bool AddAudioSourceElement();
     bool AddAudioParserElement();
+    bool AddAudioParser();
     bool AddAudioDecoderElement();
     bool AddAudioConverterElement();
     bool AddAudioSinkElement();
@@ -69,6 +93,7 @@ class BufferPlayer : public AbstractPlayer {
     /* for video */
     bool AddVideoSourceElement();
     bool AddVideoParserElement();
+    bool AddVideoParser();
     bool AddVideoDecoderElement();
     bool AddVideoConverterElement();
     bool AddVideoSinkElement();
@@ -84,9 +109,44 @@ class BufferPlayer : public AbstractPlayer {
     bool ConnectBusCallback();
     bool DisconnectBusCallback();
 
+    bool IsPipelinePoolable() const;
+    bool AcquirePooledPipeline();
+    void ApplyDisplay();
+    void ReleasePipeline() override;
+    void ReuseAppSrc(MEDIA_SRC_T* pAppSrcInfo, guint64 bufferMaxLevel);
+    void ResetChannels();
+
+    bool CanReconfigure(const MEDIA_LOAD_DATA_T* loadData) const;
+    bool ReconfigurePipeline(const MEDIA_LOAD_DATA_T* loadData,
+                             guint64* demand);
+    bool RebuildVideoDecodeChain();
+    bool RebuildAudioDecodeChain();
+    void RemoveElement(GstElement** element);
+
     bool PauseInternal();
     bool SeekInternal(const int64_t msecond);
 
+    MEDIA_STATUS_T CheckFeed(guint32 bufferSize, MEDIA_DATA_CHANNEL_T esData,
+                             MEDIA_SRC_T** ppAppSrcInfo);
+    MEDIA_STATUS_T GetFeedSrcInfo(MEDIA_DATA_CHANNEL_T esData,
+                                  MEDIA_SRC_T** ppAppSrcInfo);
+    GstBuffer* CreateFeedBuffer(MEDIA_SRC_T* pAppSrcInfo,
+                                const guint8* pBuffer, guint32 bufferSize);
+    MEDIA_STATUS_T PushFeedBuffer(MEDIA_SRC_T* pAppSrcInfo,
+                                  GstBuffer* appSrcBuffer, guint64 pts,
+                                  MEDIA_DATA_CHANNEL_T esData);
+
+    void StartFeedThread();
+    void StopFeedThread();
+    void WakeFeedThread();
+    void FeedThreadLoop();
+    bool DrainFeedRing(MEDIA_SRC_T* pAppSrcInfo);
+    void DiscardQueuedFeed();
+
+    guint64 GetAvailableBytes(MEDIA_SRC_T* pAppSrcInfo);
+    static guint64 GetQueuedTime(MEDIA_SRC_T* pAppSrcInfo);
+    static void UpdateTailPts(MEDIA_SRC_T* pAppSrcInfo, guint64 pts);
+    bool IsTimeLimitReached(MEDIA_SRC_T* pAppSrcInfo);
     bool IsBufferAvailable(MEDIA_SRC_T* pAppSrcInfo, guint64 newBufferSize);
     bool IsFeedPossible(MEDIA_SRC_T* pAppSrcInfo, guint64 bufferSize);
 
@@ -101,13 +161,26 @@ class BufferPlayer : public AbstractPlayer {
     bool NotifyActivity();
 
     static void EnoughData(GstElement* gstAppSrc, gpointer userData);
+    static void NeedData(GstElement* gstAppSrc, guint length,
+                         gpointer userData);
     static gboolean SeekData(GstElement* gstAppSrc, guint64 position,
                              gpointer userData);
+    static GstPadProbeReturn AppSrcProbe(GstPad* pad, GstPadProbeInfo* info,
+                                         gpointer userData);
+    static void ReleaseQueuedBytes(MEDIA_SRC_T* pAppSrcInfo, guint64 size);
 
     void SetDecoderSpecificInfomation();
 
     base::source_info_t GetSourceInfo(const MEDIA_LOAD_DATA_T* loadData);
-    void SetAppSrcProperties(MEDIA_SRC_T* pAppSrcInfo, guint64 bufferMaxLevel);
+    void AdaptChannelBufferSize(MEDIA_SRC_T* pAppSrcInfo, guint minBufferSize,
+                                GstElement* parserQueue);
+    void ApplyChannelBufferSize(MEDIA_SRC_T* pAppSrcInfo,
+                                GstElement* parserQueue);
+    void SetMemoryLimit(guint64 limit) override;
+    void SetAppSrcProperties(MEDIA_SRC_T* pAppSrcInfo, guint64 bufferMaxLevel,
+                             guint64 bufferMaxTime);
+    void ConnectAppSrcSignals(MEDIA_SRC_T* pAppSrcInfo);
+    static void AddAppSrcProbe(MEDIA_SRC_T* pAppSrcInfo);
     void SetDebugDumpFileName();
 
     /* for debugging */
@@ -157,6 +230,20 @@ class BufferPlayer : public AbstractPlayer {
     gchar* inputDumpFileName = nullptr;
 
     GstSegment segment_;
+    guint adaptiveTimerId_ = 0;
+
+    /* pipeline pool */
+    bool poolable_ = false;
+    bool pooledLoad_ = false;
+
+    /* async feed mode */
+    std::thread feedThread_;
+    std::mutex feedThreadLock_;
+    std::condition_variable feedThreadCond_;
+    std::atomic<bool> feedThreadStop_ { false };
+    bool feedThreadWakeup_ = false;
+    std::mutex feedPushLock_;
+    std::atomic<guint32> feedSeq_ { 0 };
 };
 
 }  // namespace player
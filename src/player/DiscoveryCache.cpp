@@ -0,0 +1,316 @@
+// Copyright (c) 2020 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#include "DiscoveryCache.h"
+
+#include <cstring>
+#include <glib/gstdio.h>
+#include <sys/stat.h>
+#include <log/log.h>
+
+#include "ElementFactory.h"
+
+namespace gmp { namespace player {
+
+namespace {
+
+const char kDefaultCacheFile[] = "/var/cache/g-media-pipeline/discovery.cache";
+
+// Values are stored in host byte order, the file never leaves the device.
+class Writer {
+ public:
+  template <typename T>
+  void Put(T value) {
+    data_.append(reinterpret_cast<const char *>(&value), sizeof(value));
+  }
+  void PutString(const std::string &str) {
+    Put<guint32>(str.size());
+    data_.append(str);
+  }
+  const std::string& data() const { return data_; }
+
+ private:
+  std::string data_;
+};
+
+class Reader {
+ public:
+  Reader(const gchar *data, gsize length) : data_(data), length_(length) {}
+
+  template <typename T>
+  bool Get(T *value) {
+    if (length_ - pos_ < sizeof(T))
+      return false;
+    memcpy(value, data_ + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+  bool GetString(std::string *str) {
+    guint32 size = 0;
+    if (!Get(&size) || length_ - pos_ < size)
+      return false;
+    str->assign(data_ + pos_, size);
+    pos_ += size;
+    return true;
+  }
+
+ private:
+  const gchar *data_;
+  gsize length_;
+  gsize pos_ = 0;
+};
+
+void PutInfo(Writer *writer, const base::source_info_t &info) {
+  writer->PutString(info.container);
+  writer->Put<gint64>(info.duration);
+  writer->Put<guint8>(info.seekable);
+  writer->Put<guint32>(info.video_streams.size());
+  for (const base::video_info_t &video : info.video_streams) {
+    writer->Put<guint32>(video.width);
+    writer->Put<guint32>(video.height);
+    writer->Put<guint64>(video.bit_rate);
+    writer->Put<gint32>(video.frame_rate.num);
+    writer->Put<gint32>(video.frame_rate.den);
+  }
+  writer->Put<guint32>(info.audio_streams.size());
+  for (const base::audio_info_t &audio : info.audio_streams) {
+    writer->Put<guint64>(audio.bit_rate);
+    writer->Put<guint32>(audio.sample_rate);
+    writer->Put<gint32>(audio.channels);
+  }
+}
+
+bool GetInfo(Reader *reader, base::source_info_t *info) {
+  gint64 duration = 0;
+  guint8 seekable = 0;
+  guint32 count = 0;
+  if (!reader->GetString(&info->container) || !reader->Get(&duration) ||
+      !reader->Get(&seekable) || !reader->Get(&count))
+    return false;
+  info->duration = duration;
+  info->seekable = seekable;
+
+  for (guint32 i = 0; i < count; i++) {
+    base::video_info_t video;
+    if (!reader->Get(&video.width) || !reader->Get(&video.height) ||
+        !reader->Get(&video.bit_rate) || !reader->Get(&video.frame_rate.num) ||
+        !reader->Get(&video.frame_rate.den))
+      return false;
+    info->video_streams.push_back(video);
+  }
+
+  if (!reader->Get(&count))
+    return false;
+  for (guint32 i = 0; i < count; i++) {
+    base::audio_info_t audio;
+    if (!reader->Get(&audio.bit_rate) || !reader->Get(&audio.sample_rate) ||
+        !reader->Get(&audio.channels))
+      return false;
+    info->audio_streams.push_back(audio);
+  }
+
+  // One program, the first stream of each type is played by default.
+  base::program_info_t program;
+  program.audio_stream = 1;
+  program.video_stream = 1;
+  info->programs.push_back(program);
+  return true;
+}
+
+}  // namespace
+
+DiscoveryCache& DiscoveryCache::GetInstance() {
+  static DiscoveryCache instance;
+  return instance;
+}
+
+// GMP_DISCOVERY_CACHE moves the file, e.g. for a read-only /var.
+DiscoveryCache::DiscoveryCache() {
+  capacity_ = pf::ElementFactory::GetDiscoveryCacheSize();
+  const char *file = g_getenv("GMP_DISCOVERY_CACHE");
+  file_ = (file && *file) ? file : kDefaultCacheFile;
+  GMP_INFO_PRINT("discovery cache size %u, file %s", capacity_, file_.c_str());
+
+  if (capacity_)
+    ReadFile();
+}
+
+DiscoveryCache::~DiscoveryCache() {
+  std::string data;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (write_id_)
+      g_source_remove(write_id_);
+    write_id_ = 0;
+    if (!TakeDirtyLocked(&data))
+      return;
+  }
+  WriteFile(data);
+}
+
+bool DiscoveryCache::Lookup(const std::string &uri,
+                            base::source_info_t *info) {
+  std::string path;
+  gint64 mtime = 0;
+  gint64 size = 0;
+  if (!IsEnabled() || !GetFileIdentity(uri, &path, &mtime, &size))
+    return false;
+
+  std::lock_guard<std::mutex> lock(lock_);
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    if (it->path != path)
+      continue;
+    if (it->mtime != mtime || it->size != size) {
+      GMP_DEBUG_PRINT("stale discovery of %s", path.c_str());
+      entries_.erase(it);
+      ScheduleWriteLocked();
+      return false;
+    }
+    entries_.splice(entries_.end(), entries_, it);
+    *info = it->info;
+    GMP_DEBUG_PRINT("discovery cache hit: %s", path.c_str());
+    return true;
+  }
+  return false;
+}
+
+void DiscoveryCache::Insert(const std::string &uri,
+                            const base::source_info_t &info) {
+  Entry entry;
+  if (!IsEnabled() ||
+      !GetFileIdentity(uri, &entry.path, &entry.mtime, &entry.size))
+    return;
+  entry.info = info;
+
+  std::lock_guard<std::mutex> lock(lock_);
+  entries_.remove_if([&entry](const Entry &e) {
+    return e.path == entry.path;
+  });
+  entries_.push_back(std::move(entry));
+  while (entries_.size() > capacity_)
+    entries_.pop_front();
+
+  ScheduleWriteLocked();
+}
+
+void DiscoveryCache::ScheduleWriteLocked() {
+  dirty_ = true;
+  if (!write_id_)
+    write_id_ = g_timeout_add_seconds(kWriteDelaySec, WriteTimeout, this);
+}
+
+gboolean DiscoveryCache::WriteTimeout(gpointer user_data) {
+  DiscoveryCache *cache = static_cast<DiscoveryCache *>(user_data);
+  std::string data;
+  {
+    std::lock_guard<std::mutex> lock(cache->lock_);
+    cache->write_id_ = 0;
+    if (!cache->TakeDirtyLocked(&data))
+      return G_SOURCE_REMOVE;
+  }
+  cache->WriteFile(data);
+  return G_SOURCE_REMOVE;
+}
+
+bool DiscoveryCache::GetFileIdentity(const std::string &uri,
+                                     std::string *path,
+                                     gint64 *mtime, gint64 *size) {
+  if (!uri.empty() && uri[0] == '/') {
+    *path = uri;
+  } else if (g_str_has_prefix(uri.c_str(), "file://")) {
+    gchar *filename = g_filename_from_uri(uri.c_str(), NULL, NULL);
+    if (!filename)
+      return false;
+    *path = filename;
+    g_free(filename);
+  } else {
+    return false;
+  }
+
+  GStatBuf st;
+  if (g_stat(path->c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+    return false;
+  // A same size rewrite within the same second must not match.
+  *mtime = (gint64)st.st_mtim.tv_sec * G_GINT64_CONSTANT(1000000000) +
+           st.st_mtim.tv_nsec;
+  *size = st.st_size;
+  return true;
+}
+
+// A missing, truncated or foreign file just leaves the cache empty.
+void DiscoveryCache::ReadFile() {
+  gchar *data = NULL;
+  gsize length = 0;
+  if (!g_file_get_contents(file_.c_str(), &data, &length, NULL))
+    return;
+
+  Reader reader(data, length);
+  guint32 magic = 0;
+  guint32 version = 0;
+  guint32 count = 0;
+  if (reader.Get(&magic) && magic == kMagic &&
+      reader.Get(&version) && version == kVersion && reader.Get(&count)) {
+    for (guint32 i = 0; i < count && entries_.size() < capacity_; i++) {
+      Entry entry;
+      if (!reader.GetString(&entry.path) || !reader.Get(&entry.mtime) ||
+          !reader.Get(&entry.size) || !GetInfo(&reader, &entry.info))
+        break;
+      entries_.push_back(std::move(entry));
+    }
+  }
+  g_free(data);
+
+  GMP_DEBUG_PRINT("%zu discoveries read from %s", entries_.size(),
+                  file_.c_str());
+}
+
+// Serializes the entries when they changed since the last write.
+bool DiscoveryCache::TakeDirtyLocked(std::string *data) {
+  if (!dirty_)
+    return false;
+  dirty_ = false;
+
+  Writer writer;
+  writer.Put<guint32>(kMagic);
+  writer.Put<guint32>(kVersion);
+  writer.Put<guint32>(entries_.size());
+  for (const Entry &entry : entries_) {
+    writer.PutString(entry.path);
+    writer.Put<gint64>(entry.mtime);
+    writer.Put<gint64>(entry.size);
+    PutInfo(&writer, entry.info);
+  }
+  *data = writer.data();
+  return true;
+}
+
+void DiscoveryCache::WriteFile(const std::string &data) {
+  gchar *dir = g_path_get_dirname(file_.c_str());
+  g_mkdir_with_parents(dir, 0755);
+  g_free(dir);
+
+  // g_file_set_contents() renames a temporary file, readers never see
+  // a partial write.
+  GError *err = NULL;
+  if (!g_file_set_contents(file_.c_str(), data.data(), data.size(), &err)) {
+    GMP_DEBUG_PRINT("write %s failed: %s", file_.c_str(), err->message);
+    g_clear_error(&err);
+  }
+}
+
+}  // namespace player
+}  // namespace gmp
@@ -0,0 +1,78 @@
+// Copyright (c) 2020 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef SRC_PLAYER_DISCOVERY_CACHE_H_
+#define SRC_PLAYER_DISCOVERY_CACHE_H_
+
+#include <glib.h>
+#include <list>
+#include <mutex>
+#include <string>
+
+#include <base/types.h>
+
+namespace gmp { namespace player {
+
+/* Process-wide cache of the source info UriPlayer gets from GstDiscoverer,
+ * keyed by (path, mtime, size) of local files. Entries are kept in
+ * least recently used order, at most "discovery_cache_size" of them from
+ * gst_elements.conf, and written to a binary file so they survive a
+ * restart. The file is written from the main loop a few seconds after the
+ * last change, or at exit, never from the thread that inserts. Remote URIs
+ * are never cached, a stale entry could only be detected with an extra
+ * request. */
+class DiscoveryCache {
+ public:
+  static DiscoveryCache& GetInstance();
+
+  bool IsEnabled() const { return capacity_ > 0; }
+  bool Lookup(const std::string &uri, base::source_info_t *info);
+  void Insert(const std::string &uri, const base::source_info_t &info);
+
+ private:
+  struct Entry {
+    std::string path;
+    gint64 mtime;  // nanoseconds
+    gint64 size;
+    base::source_info_t info;
+  };
+
+  DiscoveryCache();
+  ~DiscoveryCache();
+  static bool GetFileIdentity(const std::string &uri, std::string *path,
+                              gint64 *mtime, gint64 *size);
+  static gboolean WriteTimeout(gpointer user_data);
+  void ScheduleWriteLocked();
+  void ReadFile();
+  bool TakeDirtyLocked(std::string *data);
+  void WriteFile(const std::string &data);
+
+  static constexpr guint32 kMagic = 0x444d4d47;  // "GMMD"
+  static constexpr guint32 kVersion = 2;
+  static constexpr guint kWriteDelaySec = 5;
+
+  std::mutex lock_;
+  std::list<Entry> entries_;  // least recently used first
+  guint32 capacity_;
+  std::string file_;
+  bool dirty_ = false;
+  guint write_id_ = 0;
+};
+
+}  // namespace player
+}  // namespace gmp
+#endif  // SRC_PLAYER_DISCOVERY_CACHE_H_
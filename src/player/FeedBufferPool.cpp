@@ -0,0 +1,105 @@
+// Copyright (c) 2020 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#include "FeedBufferPool.h"
+
+#include <string.h>
+#include <log/log.h>
+
+namespace gmp { namespace player {
+
+FeedBufferPool::FeedBufferPool(guint channelMaxBytes)
+  : channelMaxBytes_(channelMaxBytes),
+    maxClassShift_(kMinClassShift),
+    hitCount_(0),
+    missCount_(0) {
+  // The largest class is a quarter of the appsrc limit, anything bigger is
+  // rare enough (I-frames of high bitrate streams) to go through malloc.
+  while ((1u << (maxClassShift_ + 1)) <= channelMaxBytes_ / 4)
+    maxClassShift_++;
+  pools_.resize(maxClassShift_ - kMinClassShift + 1, nullptr);
+}
+
+FeedBufferPool::~FeedBufferPool() {
+  GMP_DEBUG_PRINT("pool hit[%" G_GUINT64_FORMAT "] miss[%" G_GUINT64_FORMAT "]",
+                  (guint64)hitCount_, (guint64)missCount_);
+  for (auto pool : pools_) {
+    if (!pool)
+      continue;
+    gst_buffer_pool_set_active(pool, FALSE);
+    gst_object_unref(pool);
+  }
+}
+
+GstBufferPool* FeedBufferPool::GetPool(guint classIndex) {
+  std::lock_guard<std::mutex> lock(lock_);
+  GstBufferPool *pool = pools_[classIndex];
+  if (pool)
+    return pool;
+
+  guint classSize = 1u << (kMinClassShift + classIndex);
+  // appsrc never queues more than channelMaxBytes_, so that bounds the
+  // number of buffers of one class in flight.
+  guint maxBuffers = MAX(kMinBuffersPerPool, channelMaxBytes_ / classSize);
+
+  pool = gst_buffer_pool_new();
+  GstStructure *config = gst_buffer_pool_get_config(pool);
+  gst_buffer_pool_config_set_params(config, NULL, classSize, 0, maxBuffers);
+  if (!gst_buffer_pool_set_config(pool, config) ||
+      !gst_buffer_pool_set_active(pool, TRUE)) {
+    GMP_INFO_PRINT("Failed to activate feed pool of size %u", classSize);
+    gst_object_unref(pool);
+    return nullptr;
+  }
+
+  GMP_DEBUG_PRINT("New feed pool size[%u] max buffers[%u]", classSize, maxBuffers);
+  pools_[classIndex] = pool;
+  return pool;
+}
+
+GstBuffer* FeedBufferPool::Acquire(const guint8* pBuffer, guint32 bufferSize) {
+  guint shift = kMinClassShift;
+  while (shift <= maxClassShift_ && (1u << shift) < bufferSize)
+    shift++;
+
+  if (shift <= maxClassShift_) {
+    GstBufferPool *pool = GetPool(shift - kMinClassShift);
+    GstBuffer *buffer = nullptr;
+    GstBufferPoolAcquireParams params = { };
+    params.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+    if (pool &&
+        gst_buffer_pool_acquire_buffer(pool, &buffer, &params) == GST_FLOW_OK) {
+      // The pool restores the full class size when the buffer comes back.
+      gst_buffer_fill(buffer, 0, pBuffer, bufferSize);
+      gst_buffer_set_size(buffer, bufferSize);
+      hitCount_++;
+      return buffer;
+    }
+  }
+
+  missCount_++;
+  guint8 *feedBuffer = (guint8 *)g_malloc(bufferSize);
+  if (feedBuffer == NULL) {
+    GMP_DEBUG_PRINT("memory allocation error!!!!!");
+    return nullptr;
+  }
+  memcpy(feedBuffer, pBuffer, bufferSize);
+  return gst_buffer_new_wrapped(feedBuffer, bufferSize);
+}
+
+}  // namespace player
+}  // namespace gmp
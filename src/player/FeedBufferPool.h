@@ -0,0 +1,60 @@
+// Copyright (c) 2020 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef SRC_PLAYER_FEED_BUFFER_POOL_H_
+#define SRC_PLAYER_FEED_BUFFER_POOL_H_
+
+#include <gst/gst.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace gmp { namespace player {
+
+/* Size-classed GstBufferPool set for one appsrc channel.
+ * Each power-of-two class gets its own pool the first time an AU of that
+ * size is fed, so steady-state feeding reuses buffers instead of allocating.
+ * AUs bigger than the largest class or a drained pool fall back to malloc.
+ * A pooled buffer keeps its full class size as maxsize, BufferPlayer counts
+ * that against the channel limit rather than the AU size. */
+class FeedBufferPool {
+ public:
+  explicit FeedBufferPool(guint channelMaxBytes);
+  ~FeedBufferPool();
+
+  GstBuffer* Acquire(const guint8* pBuffer, guint32 bufferSize);
+
+  guint64 GetHitCount() const { return hitCount_; }
+  guint64 GetMissCount() const { return missCount_; }
+
+ private:
+  GstBufferPool* GetPool(guint classIndex);
+
+  static constexpr guint kMinClassShift = 10;   // 1KB
+  static constexpr guint kMinBuffersPerPool = 4;
+
+  guint channelMaxBytes_;
+  guint maxClassShift_;
+  std::mutex lock_;
+  std::vector<GstBufferPool*> pools_;
+  std::atomic<guint64> hitCount_;
+  std::atomic<guint64> missCount_;
+};
+
+}  // namespace player
+}  // namespace gmp
+#endif  // SRC_PLAYER_FEED_BUFFER_POOL_H_
@@ -0,0 +1,65 @@
+// Copyright (c) 2020 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#include "FeedRing.h"
+
+namespace gmp { namespace player {
+
+FeedRing::FeedRing(guint capacity)
+  : capacity_(1), head_(0), tail_(0) {
+  while (capacity_ < capacity)
+    capacity_ <<= 1;
+  mask_ = capacity_ - 1;
+  entries_.resize(capacity_);
+}
+
+FeedRing::~FeedRing() {
+  GstBuffer *buffer = nullptr;
+  guint32 seq = 0;
+  while (Front(&buffer, &seq)) {
+    gst_buffer_unref(buffer);
+    Pop();
+  }
+}
+
+bool FeedRing::Push(GstBuffer* buffer, guint32 seq) {
+  guint tail = tail_.load(std::memory_order_relaxed);
+  if (tail - head_.load(std::memory_order_acquire) >= capacity_)
+    return false;
+
+  entries_[tail & mask_] = { buffer, seq };
+  tail_.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+bool FeedRing::Front(GstBuffer** buffer, guint32* seq) const {
+  guint head = head_.load(std::memory_order_relaxed);
+  if (head == tail_.load(std::memory_order_acquire))
+    return false;
+
+  *buffer = entries_[head & mask_].buffer;
+  *seq = entries_[head & mask_].seq;
+  return true;
+}
+
+void FeedRing::Pop() {
+  head_.store(head_.load(std::memory_order_relaxed) + 1,
+              std::memory_order_release);
+}
+
+}  // namespace player
+}  // namespace gmp
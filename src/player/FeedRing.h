@@ -0,0 +1,59 @@
+// Copyright (c) 2020 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef SRC_PLAYER_FEED_RING_H_
+#define SRC_PLAYER_FEED_RING_H_
+
+#include <gst/gst.h>
+#include <atomic>
+#include <vector>
+
+namespace gmp { namespace player {
+
+/* Bounded single-producer/single-consumer queue of GstBuffers.
+ * The feeding thread is the only producer (Push/IsFull), the pusher thread
+ * is the only consumer (Front/Pop). Each entry carries the flush sequence
+ * it was queued under so the consumer can drop data older than a flush. */
+class FeedRing {
+ public:
+  explicit FeedRing(guint capacity);
+  ~FeedRing();
+
+  bool Push(GstBuffer* buffer, guint32 seq);
+  bool Front(GstBuffer** buffer, guint32* seq) const;
+  void Pop();
+
+  bool IsFull() const { return GetDepth() >= capacity_; }
+  guint GetDepth() const { return tail_.load() - head_.load(); }
+  guint GetCapacity() const { return capacity_; }
+
+ private:
+  struct Entry {
+    GstBuffer *buffer;
+    guint32 seq;
+  };
+
+  guint capacity_;
+  guint mask_;
+  std::vector<Entry> entries_;
+  std::atomic<guint> head_;  // next entry to read, consumer only
+  std::atomic<guint> tail_;  // next entry to write, producer only
+};
+
+}  // namespace player
+}  // namespace gmp
+#endif  // SRC_PLAYER_FEED_RING_H_
@@ -0,0 +1,158 @@
+// Copyright (c) 2020 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#include "MemoryBudget.h"
+
+#include <gst/gst.h>
+#include <log/log.h>
+
+#include "ElementFactory.h"
+
+namespace gmp { namespace player {
+
+MemoryBudget& MemoryBudget::GetInstance() {
+  static MemoryBudget instance;
+  return instance;
+}
+
+MemoryBudget::MemoryBudget() {
+  guint64 budgetMb = pf::ElementFactory::GetMemoryBudget();
+  budget_ = budgetMb ? budgetMb * 1024 * 1024 : kDefaultBudget;
+  GMP_INFO_PRINT("memory budget %" G_GUINT64_FORMAT " bytes", budget_);
+}
+
+guint32 MemoryBudget::Register(guint64 demand, LimitCallback onLimit,
+                               UsageCallback getUsage) {
+  guint32 id;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    id = nextId_++;
+    clients_[id] = { demand, demand, true, onLimit, getUsage };
+    GMP_DEBUG_PRINT("register [%u] demand %" G_GUINT64_FORMAT, id, demand);
+    Rebalance();
+  }
+  NotifyLimits();
+  Dump();
+  return id;
+}
+
+void MemoryBudget::Unregister(guint32 id) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!clients_.erase(id))
+      return;
+    GMP_DEBUG_PRINT("unregister [%u]", id);
+    Rebalance();
+  }
+  // Also waits for a NotifyLimits() on another thread that may still be
+  // calling this client.
+  NotifyLimits();
+  Dump();
+}
+
+void MemoryBudget::SetForeground(guint32 id, bool foreground) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = clients_.find(id);
+    if (it == clients_.end() || it->second.foreground == foreground)
+      return;
+    it->second.foreground = foreground;
+    Rebalance();
+  }
+  NotifyLimits();
+  Dump();
+}
+
+// Logged after every rebalance and on logPipelineState.
+void MemoryBudget::Dump() {
+  std::lock_guard<std::mutex> callbackLock(callbackLock_);
+  std::map<guint32, Client> clients;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    clients = clients_;
+  }
+
+  guint64 total = 0;
+  for (auto &client : clients) {
+    guint64 usage = client.second.getUsage ? client.second.getUsage() : 0;
+    total += usage;
+    GMP_INFO_PRINT("[%u] %s usage %" G_GUINT64_FORMAT " / limit %"
+                   G_GUINT64_FORMAT " (demand %" G_GUINT64_FORMAT ")",
+                   client.first,
+                   client.second.foreground ? "foreground" : "background",
+                   usage, client.second.limit, client.second.demand);
+  }
+  GMP_INFO_PRINT("memory budget usage %" G_GUINT64_FORMAT " / %"
+                 G_GUINT64_FORMAT, total, budget_);
+}
+
+// Shares budget among one group in proportion to demand, never below
+// kMinLimit so that a squeezed player can still make progress.
+void MemoryBudget::Distribute(std::map<guint32, Client> &clients,
+                              bool foreground, guint64 budget,
+                              guint64 demand) {
+  for (auto &client : clients) {
+    Client &c = client.second;
+    if (c.foreground != foreground)
+      continue;
+    guint64 limit = c.demand;
+    if (demand > budget)
+      limit = demand ? gst_util_uint64_scale(c.demand, budget, demand) : 0;
+    c.limit = MIN(c.demand, MAX(limit, kMinLimit));
+  }
+}
+
+void MemoryBudget::Rebalance() {
+  guint64 fgDemand = 0, bgDemand = 0;
+  for (auto &client : clients_) {
+    if (client.second.foreground)
+      fgDemand += client.second.demand;
+    else
+      bgDemand += client.second.demand;
+  }
+
+  // Foreground first, background players get what is left.
+  guint64 fgBudget = MIN(fgDemand, budget_);
+  Distribute(clients_, true, fgBudget, fgDemand);
+  Distribute(clients_, false, budget_ - fgBudget, bgDemand);
+
+  for (auto &client : clients_) {
+    GMP_DEBUG_PRINT("[%u] limit %" G_GUINT64_FORMAT, client.first,
+                    client.second.limit);
+  }
+}
+
+// Limits are read under lock_ and handed out after releasing it, in
+// case a client's callback ends up waiting on a thread that is itself
+// blocked on lock_.
+void MemoryBudget::NotifyLimits() {
+  std::lock_guard<std::mutex> callbackLock(callbackLock_);
+  std::vector<std::pair<LimitCallback, guint64>> limits;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    for (auto &client : clients_) {
+      if (client.second.onLimit)
+        limits.emplace_back(client.second.onLimit, client.second.limit);
+    }
+  }
+
+  for (auto &limit : limits)
+    limit.first(limit.second);
+}
+
+}  // namespace player
+}  // namespace gmp
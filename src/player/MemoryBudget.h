@@ -0,0 +1,80 @@
+// Copyright (c) 2020 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef SRC_PLAYER_MEMORY_BUDGET_H_
+#define SRC_PLAYER_MEMORY_BUDGET_H_
+
+#include <glib.h>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace gmp { namespace player {
+
+/* Process-wide budget for the bytes players keep queued in appsrc, queue
+ * and queue2 elements. Each player registers what it would like to hold,
+ * and gets a limit back whenever players come, go or change foreground
+ * state. Foreground players are served first, background players shrink
+ * first. Callbacks run without the budget lock but may run on any thread
+ * that changed the budget, possibly while it holds another player's lock:
+ * they must not take locks of their own. Once Unregister() returns no
+ * callback of that client is running or will run. */
+class MemoryBudget {
+ public:
+  using LimitCallback = std::function<void(guint64 limit)>;
+  using UsageCallback = std::function<guint64()>;
+
+  static MemoryBudget& GetInstance();
+
+  guint32 Register(guint64 demand, LimitCallback onLimit,
+                   UsageCallback getUsage);
+  void Unregister(guint32 id);
+  void SetForeground(guint32 id, bool foreground);
+
+  guint64 GetBudget() const { return budget_; }
+  void Dump();
+
+ private:
+  struct Client {
+    guint64 demand;
+    guint64 limit;
+    bool foreground;
+    LimitCallback onLimit;
+    UsageCallback getUsage;
+  };
+
+  MemoryBudget();
+  void Rebalance();
+  void NotifyLimits();
+  static void Distribute(std::map<guint32, Client> &clients, bool foreground,
+                         guint64 budget, guint64 demand);
+
+  static constexpr guint64 kDefaultBudget = 64 * 1024 * 1024;
+  static constexpr guint64 kMinLimit = 1 * 1024 * 1024;
+
+  std::mutex lock_;
+  std::mutex callbackLock_;  // taken before lock_, held while calling out
+  std::map<guint32, Client> clients_;
+  guint32 nextId_ = 1;
+  guint64 budget_;
+};
+
+}  // namespace player
+}  // namespace gmp
+#endif  // SRC_PLAYER_MEMORY_BUDGET_H_
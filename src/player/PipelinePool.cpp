@@ -0,0 +1,110 @@
+// Copyright (c) 2020 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+#include "PipelinePool.h"
+
+#include <log/log.h>
+
+#include "ElementFactory.h"
+
+namespace gmp { namespace player {
+
+PipelinePool& PipelinePool::GetInstance() {
+  static PipelinePool instance;
+  return instance;
+}
+
+PipelinePool::Key PipelinePool::MakeKey(GMP_VIDEO_CODEC videoCodec,
+                                        GMP_AUDIO_CODEC audioCodec,
+                                        guint32 displayPath,
+                                        const std::string &windowId) {
+  return std::make_tuple(static_cast<gint32>(videoCodec),
+                         static_cast<gint32>(audioCodec), displayPath,
+                         windowId);
+}
+
+PipelinePool::PipelinePool() {
+  capacity_ = pf::ElementFactory::GetPipelinePoolSize();
+  GMP_INFO_PRINT("pipeline pool size %u", capacity_);
+}
+
+PipelinePool::~PipelinePool() {
+  for (auto &it : entries_)
+    Destroy(std::move(it.second));
+}
+
+std::unique_ptr<PipelinePool::Entry> PipelinePool::Acquire(const Key &key) {
+  std::lock_guard<std::mutex> lock(lock_);
+  // newest first, it has been idle the shortest
+  for (auto it = entries_.rbegin(); it != entries_.rend(); ++it) {
+    if (it->first != key)
+      continue;
+    std::unique_ptr<Entry> entry = std::move(it->second);
+    entries_.erase(std::next(it).base());
+    return entry;
+  }
+  return nullptr;
+}
+
+bool PipelinePool::Release(const Key &key, std::unique_ptr<Entry> entry) {
+  if (!entry || !entry->pipeline || !capacity_)
+    return false;
+
+  std::unique_ptr<Entry> evicted;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (entries_.size() >= capacity_) {
+      evicted = std::move(entries_.front().second);
+      entries_.pop_front();
+    }
+    entries_.emplace_back(key, std::move(entry));
+  }
+
+  if (evicted) {
+    GMP_DEBUG_PRINT("pool full, drop pipeline %p", evicted->pipeline);
+    Destroy(std::move(evicted));
+  }
+  return true;
+}
+
+void PipelinePool::RecordLoad(bool hit, gint64 usec) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (hit) {
+    hits_++;
+    hitLoadUsec_ += usec;
+  } else {
+    misses_++;
+    missLoadUsec_ += usec;
+  }
+}
+
+void PipelinePool::Dump() {
+  std::lock_guard<std::mutex> lock(lock_);
+  GMP_INFO_PRINT("pipeline pool: %zu idle, hits %" G_GUINT64_FORMAT
+                 " (avg load %" G_GINT64_FORMAT " us), misses %" G_GUINT64_FORMAT
+                 " (avg load %" G_GINT64_FORMAT " us)",
+                 entries_.size(),
+                 hits_, hits_ ? hitLoadUsec_ / (gint64)hits_ : 0,
+                 misses_, misses_ ? missLoadUsec_ / (gint64)misses_ : 0);
+}
+
+void PipelinePool::Destroy(std::unique_ptr<Entry> entry) {
+  gst_element_set_state(entry->pipeline, GST_STATE_NULL);
+  gst_object_unref(entry->pipeline);
+}
+
+}  // namespace player
+}  // namespace gmp
@@ -0,0 +1,89 @@
+// Copyright (c) 2020 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+#ifndef SRC_PLAYER_PIPELINE_POOL_H_
+#define SRC_PLAYER_PIPELINE_POOL_H_
+
+#include <gst/gst.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "PlayerTypes.h"
+
+namespace gmp { namespace player {
+
+/* Process-wide pool of idle BufferPlayer pipelines, keyed by (videoCodec,
+ * audioCodec, displayPath, windowId). Unload hands its pipeline back
+ * instead of tearing it down, and the next Load with the same key picks it
+ * up without building the element chain again. Pipelines are parked in
+ * NULL, or in READY when "pipeline_pool_ready" is set. The pool holds at
+ * most "pipeline_pool_size" pipelines from gst_elements.conf, 0 disables
+ * it. */
+class PipelinePool {
+ public:
+  typedef std::tuple<gint32, gint32, guint32, std::string> Key;
+
+  // What BufferPlayer needs back to drive a pooled pipeline.
+  struct Entry {
+    GstElement *pipeline = nullptr;
+    std::shared_ptr<MEDIA_SRC_T> videoSrcInfo;
+    std::shared_ptr<MEDIA_SRC_T> audioSrcInfo;
+    GstElement *videoPQueue = nullptr;
+    GstElement *videoParser = nullptr;
+    GstElement *videoDecoder = nullptr;
+    GstElement *videoPostProc = nullptr;
+    GstElement *videoQueue = nullptr;
+    GstElement *vConverter = nullptr;
+    GstElement *videoSink = nullptr;
+    GstElement *audioPQueue = nullptr;
+    GstElement *audioParser = nullptr;
+    GstElement *audioDecoder = nullptr;
+    GstElement *audioConverter = nullptr;
+    GstElement *audioQueue = nullptr;
+    GstElement *audioSink = nullptr;
+  };
+
+  static PipelinePool& GetInstance();
+  static Key MakeKey(GMP_VIDEO_CODEC videoCodec, GMP_AUDIO_CODEC audioCodec,
+                     guint32 displayPath, const std::string &windowId);
+
+  bool IsEnabled() const { return capacity_ > 0; }
+  std::unique_ptr<Entry> Acquire(const Key &key);
+  bool Release(const Key &key, std::unique_ptr<Entry> entry);
+  void RecordLoad(bool hit, gint64 usec);
+  void Dump();
+
+ private:
+  PipelinePool();
+  ~PipelinePool();
+  static void Destroy(std::unique_ptr<Entry> entry);
+
+  std::mutex lock_;
+  std::list<std::pair<Key, std::unique_ptr<Entry>>> entries_;  // oldest first
+  guint32 capacity_;
+  guint64 hits_ = 0;
+  guint64 misses_ = 0;
+  gint64 hitLoadUsec_ = 0;
+  gint64 missLoadUsec_ = 0;
+};
+
+}  // namespace player
+}  // namespace gmp
+#endif  // SRC_PLAYER_PIPELINE_POOL_H_
@@ -39,22 +39,35 @@ class Player {
   Player() {}
   virtual ~Player() {}
 
-  virtual bool Load(const std::string &str) = 0;
+  virtual bool Load(const base::load_param_t &param) = 0;
   virtual bool Load(const MEDIA_LOAD_DATA_T* loadData) = 0;
   virtual bool Unload() = 0;
+  virtual bool Reconfigure(const MEDIA_LOAD_DATA_T* loadData) = 0;
   virtual bool Play() = 0;
   virtual bool Pause() = 0;
   virtual bool SetPlayRate(const double rate) = 0;
   virtual bool Seek(const int64_t position) = 0;
+  virtual bool SelectTrack(const std::string &type, int32_t index) = 0;
   virtual bool SetVolume(int volume) = 0;
   virtual bool SetPlane(int planeId) = 0;
+  virtual bool SetUpdateInterval(int32_t intervalMs) = 0;
   virtual bool SetDisplayPath(const uint32_t display_path) = 0;
 
   virtual void notifyFunctionUMSPolicyAction() = 0;
   virtual bool UpdateVideoResData(const gmp::base::source_info_t &sourceInfo) = 0;
   virtual MEDIA_STATUS_T Feed(const guint8* pBuffer, guint32 bufferSize,
                         guint64 pts, MEDIA_DATA_CHANNEL_T esData) = 0;
+  virtual MEDIA_STATUS_T FeedWrapped(const guint8* pBuffer, guint32 bufferSize,
+                        guint64 pts, MEDIA_DATA_CHANNEL_T esData,
+                        GDestroyNotify releaseFunc, gpointer userData) = 0;
+  virtual MEDIA_STATUS_T FeedBatch(const MEDIA_FEED_ENTRY_T* entries,
+                        guint32 count, MEDIA_DATA_CHANNEL_T esData,
+                        guint32* accepted) = 0;
+  virtual bool GetFeedStats(MEDIA_DATA_CHANNEL_T esData,
+                            MEDIA_FEED_STATS_T* stats) = 0;
   virtual bool Flush() = 0;
+  virtual void SetForeground(bool foreground) = 0;
+  virtual guint64 GetMemoryUsage() = 0;
   virtual void RegisterCbFunction(CALLBACK_T) = 0;
   virtual bool PushEndOfStream() = 0;
   virtual GstElement* GetPipeline() = 0;
@@ -18,7 +18,9 @@
 #define SRC_PLAYER_PLAYERTYPES_H_
 
 #include <gst/gst.h>
+#include <atomic>
 #include <functional>
+#include <memory>
 #include "types.h"
 
 using CALLBACK_T = std::function<void(const gint type, const gint64 numValue,
@@ -40,7 +42,7 @@ typedef enum {
   NOTIFY_VIDEO_INFO,
   NOTIFY_AUDIO_INFO,
   NOTIFY_BUFFER_FULL,  // NOTIFY_BUFFERING_END? need to check the chromium media backend
-  NOTIFY_BUFFER_NEED,  // NOTIFY_BUFFERING_START?
+  NOTIFY_BUFFER_NEED,  // numValue: channel, strValue: {"channel", "level"}
   NOTIFY_BUFFER_RANGE,
   NOTIFY_BUFFERING_START,
   NOTIFY_BUFFERING_END,
@@ -193,6 +195,8 @@ typedef struct MEDIA_LOAD_DATA {
   guint32 svpVersion;
   GMP_AUDIO_SAMPLE_FORMAT sampleFormat;
   gboolean liveStream;
+  gboolean asyncFeed;   /* Feed() only queues, a player thread pushes to appsrc */
+  guint64 bufferMaxTime; /* appsrc limit in ns, 0 to limit by bytes only */
 
   public:
     MEDIA_LOAD_DATA() : maxWidth(0), maxHeight(0), maxFrameRate(0),
@@ -202,7 +206,8 @@ typedef struct MEDIA_LOAD_DATA {
                         blockAlign(0), bitRate(0), bitsPerSample(0), format(NULL),
                         audioObjectType(0), codecData(NULL), codecDataSize(0),
                         drmType(DRM_UNKNOWN), svpVersion(0), liveStream(false),
-                        sampleFormat(GMP_AUDIO_FORMAT_UNKNOWN) {
+                        sampleFormat(GMP_AUDIO_FORMAT_UNKNOWN), asyncFeed(false),
+                        bufferMaxTime(0) {
     }
     MEDIA_LOAD_DATA(guint32 maxWidth_, guint32 maxHeight_, guint32 maxFrameRate_,
                     GMP_VIDEO_CODEC videoCodec_, GMP_AUDIO_CODEC audioCodec_,
@@ -244,6 +249,8 @@ typedef struct MEDIA_LOAD_DATA {
       svpVersion = svpVersion_;
       liveStream = liveStream_;
       sampleFormat = sampleFormat_;
+      asyncFeed = false;
+      bufferMaxTime = 0;
     }
 } MEDIA_LOAD_DATA_T;
 
@@ -355,15 +362,49 @@ typedef enum {
   HDMI_PIPELINE
 } PIPELINE_TYPE;
 
+namespace gmp { namespace player {
+class FeedBufferPool;
+class FeedRing;
+} }
+
 typedef struct {
   GstElement *pSrcElement;
-  guint bufferMaxByte;
+  std::atomic<guint> bufferMaxByte;  // may be lowered by adaptive sizing
+  guint channelMaxByte;              // upper bound for bufferMaxByte
+  guint adaptiveMaxByte;             // chosen from the observed bitrate
+  std::atomic<guint> budgetMaxByte;  // share of the process memory budget
   guint bufferMinPercent;
   std::string elementName;
-  CUSTOM_BUFFERING_STATE_T needFeedData;
+  std::atomic<CUSTOM_BUFFERING_STATE_T> needFeedData;  // producer and appsrc threads
   guint64 totalFeed;
+  std::atomic<guint64> queuedBytes;  // allocated bytes pushed, not yet out of appsrc
+  guint64 bufferMaxTime;             // 0 when limited by bytes only
+  std::atomic<guint64> headPts;      // PTS last seen leaving appsrc
+  std::atomic<guint64> tailPts;      // PTS last pushed
+  guint64 rateLastFeed;              // adaptive sizing window start
+  guint64 rateLastPts;
+  guint64 byteRate;                  // bytes per PTS second, 0 if unknown
+  std::shared_ptr<gmp::player::FeedBufferPool> feedPool;
+  std::shared_ptr<gmp::player::FeedRing> feedRing;  // async feed mode only
+  std::atomic<bool> eosPending;
 } MEDIA_SRC_T;
 
+typedef struct {
+  const guint8 *pBuffer;
+  guint32 bufferSize;
+  guint64 pts;
+} MEDIA_FEED_ENTRY_T;
+
+typedef struct {
+  guint64 totalFeed;
+  guint64 poolHits;
+  guint64 poolMisses;
+  guint32 ringDepth;
+  guint32 ringCapacity;
+  guint32 bufferMaxByte;
+  guint64 byteRate;
+} MEDIA_FEED_STATS_T;
+
 /* player status enum type */
 typedef enum {
   LOADING_STATE,
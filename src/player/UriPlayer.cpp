@@ -23,10 +23,10 @@
 #include <pbnjson.hpp>
 #include <sys/types.h>
 #include <unistd.h>
+#include <algorithm>
 #include <gst/video/videooverlay.h>
 #include "ElementFactory.h"
-
-#include "parser/parser.h"
+#include "DiscoveryCache.h"
 
 #define DISCOVER_EXPIRE_TIME (10 * GST_SECOND)
 #define UPDATE_INTERVAL_MS 200
@@ -40,19 +40,153 @@ UriPlayer::~UriPlayer() {
   Unload();
 }
 
-bool UriPlayer::Load(const std::string &str) {
-  GMPASSERT(!str.empty());
-  GMP_DEBUG_PRINT("load: %s", str.c_str());
-  ParseOptionString(str);
+// Load only starts the discovery, the pipeline is built in CompleteLoad()
+// once the stream info is known.
+bool UriPlayer::Load(const base::load_param_t &param) {
+  GMP_DEBUG_PRINT("load: %s", param.uri.c_str());
+  std::lock_guard<std::recursive_mutex> lock(recursive_mutex_);
+  SetLoadParam(param);
 
   // Temporary setting
   display_mode_ = std::string("Textured");
 
-  if (!GetSourceInfo()) {
-    GMP_DEBUG_PRINT("get source information failed!");
+  this->SetReloading(param.startTime);
+
+  if (DiscoveryCache::GetInstance().Lookup(uri_, &source_info_)) {
+    duration_ = source_info_.duration * GST_MSECOND;
+    return CompleteLoad();
+  }
+
+  if (pf::ElementFactory::GetSkipDiscovery())
+    return LoadWithoutDiscovery();
+
+  if (!StartDiscovery()) {
+    GMP_DEBUG_PRINT("start discovery failed!");
+    return false;
+  }
+
+  GMP_DEBUG_PRINT("Load requested, discovering: %s", uri_.c_str());
+  return true;
+}
+
+bool UriPlayer::Unload() {
+  std::lock_guard<std::recursive_mutex> lock(recursive_mutex_);
+  CancelDiscovery();
+  UnblockDecoders();
+  skip_discovery_ = false;
+  pending_state_ = base::playback_state_t::STOPPED;
+  return AbstractPlayer::Unload();
+}
+
+bool UriPlayer::StartDiscovery() {
+  GError *err = NULL;
+  discoverer_ = gst_discoverer_new((GstClockTime)DISCOVER_EXPIRE_TIME, &err);
+  if (!discoverer_) {
+    GMP_DEBUG_PRINT("discoverer creation failed: %s",
+                    err ? err->message : "unknown");
+    g_clear_error(&err);
+    return false;
+  }
+
+  g_signal_connect(discoverer_, "discovered",
+                   G_CALLBACK(HandleDiscovered), this);
+  gst_discoverer_start(discoverer_);
+
+  if (!gst_discoverer_discover_uri_async(discoverer_, uri_.c_str())) {
+    GMP_DEBUG_PRINT("discover %s failed", uri_.c_str());
+    CancelDiscovery();
+    return false;
+  }
+  return true;
+}
+
+void UriPlayer::CancelDiscovery() {
+  if (!discoverer_)
+    return;
+
+  GMP_DEBUG_PRINT("cancel discovery of %s", uri_.c_str());
+  g_signal_handlers_disconnect_by_data(discoverer_, this);
+  gst_discoverer_stop(discoverer_);
+  g_object_unref(discoverer_);
+  discoverer_ = nullptr;
+}
+
+void UriPlayer::HandleDiscovered(GstDiscoverer *discoverer,
+                                 GstDiscovererInfo *info,
+                                 GError *err, gpointer user_data) {
+  UriPlayer *player = static_cast<UriPlayer*>(user_data);
+  std::lock_guard<std::recursive_mutex> lock(player->recursive_mutex_);
+  if (discoverer != player->discoverer_)
+    return;
+
+  // The discoverer can't be stopped from its own signal emission.
+  g_signal_handlers_disconnect_by_data(discoverer, player);
+  player->discoverer_ = nullptr;
+  g_idle_add(+[] (gpointer data) -> gboolean {
+    gst_discoverer_stop(GST_DISCOVERER(data));
+    g_object_unref(data);
+    return G_SOURCE_REMOVE;
+  }, discoverer);
+
+  if (err)
+    GMP_DEBUG_PRINT("discovery result[%d]: %s",
+                    gst_discoverer_info_get_result(info), err->message);
+
+  bool discovered = player->GetSourceInfo(info);
+  if (discovered &&
+      gst_discoverer_info_get_result(info) == GST_DISCOVERER_OK)
+    DiscoveryCache::GetInstance().Insert(player->uri_, player->source_info_);
+
+  if (!discovered || !player->CompleteLoad()) {
+    base::error_t error;
+    error.errorCode = MEDIA_MSG_ERR_LOAD;
+    error.errorText = "Failed to load " + player->uri_;
+    if (player->cbFunction_)
+      player->cbFunction_(NOTIFY_ERROR, 0, nullptr, &error);
+    return;
+  }
+
+  base::playback_state_t pending = player->pending_state_;
+  player->pending_state_ = base::playback_state_t::STOPPED;
+  if (pending == base::playback_state_t::PLAYING)
+    player->Play();
+  else if (pending == base::playback_state_t::PAUSED)
+    player->Pause();
+}
+
+bool UriPlayer::CompleteLoad() {
+  if (!AcquireResources())
+    return false;
+
+  if (!LoadPipeline()) {
+    GMP_DEBUG_PRINT("pipeline load failed!");
     return false;
   }
 
+  StartLoadedTimers();
+
+  GMP_DEBUG_PRINT("Load Done: %s", uri_.c_str());
+  return true;
+}
+
+// playbin3 starts right away, the decoders wait at their sink pads until
+// the stream collection gave source info to acquire resources with.
+bool UriPlayer::LoadWithoutDiscovery() {
+  skip_discovery_ = true;
+  source_info_ = base::source_info_t();
+
+  if (!LoadPipeline()) {
+    GMP_DEBUG_PRINT("pipeline load failed!");
+    return false;
+  }
+
+  StartLoadedTimers();
+
+  GMP_DEBUG_PRINT("Load started without discovery: %s", uri_.c_str());
+  return true;
+}
+
+bool UriPlayer::AcquireResources() {
   ACQUIRE_RESOURCE_INFO_T resource_info;
   resource_info.sourceInfo = &source_info_;
   resource_info.displayMode = const_cast<char*>(display_mode_.c_str());
@@ -70,14 +204,13 @@ bool UriPlayer::Load(const std::string &str) {
     GMP_DEBUG_PRINT("attachSurface() failed");
     return false;
   }
+  return true;
+}
 
-  if (!LoadPipeline()) {
-    GMP_DEBUG_PRINT("pipeline load failed!");
-    return false;
-  }
+void UriPlayer::StartLoadedTimers() {
+  RegisterMemoryBudget(queue2MaxSizeBytes);
 
-  currPosTimerId_ = g_timeout_add(UPDATE_INTERVAL_MS,
-                            (GSourceFunc)NotifyCurrentTime, this);
+  SetPositionNotifier((GSourceFunc)NotifyCurrentTime, UPDATE_INTERVAL_MS);
 
   /* Notify buffering time in case of httpsource only */
   if (httpSource_)
@@ -85,24 +218,103 @@ bool UriPlayer::Load(const std::string &str) {
                                (GSourceFunc)NotifyBufferingTime, this);
 
   SetPlayerState(base::playback_state_t::LOADED);
+}
 
-  this->SetReloading(gmp::parser::Parser(str.c_str()).get_start_time());
+void UriPlayer::HandleStreamCollection(GstStreamCollection *collection) {
+  std::lock_guard<std::recursive_mutex> lock(recursive_mutex_);
+  gst_object_replace(reinterpret_cast<GstObject **>(&collection_),
+                     GST_OBJECT_CAST(collection));
 
-  GMP_DEBUG_PRINT("Load Done: %s", uri_.c_str());
-  return true;
+  if (!skip_discovery_ || source_info_ready_)
+    return;
+
+  if (!GetSourceInfo(collection)) {
+    GMP_DEBUG_PRINT("waiting for a stream collection with A/V streams");
+    return;
+  }
+  source_info_ready_ = true;
+
+  if (!AcquireResources()) {
+    base::error_t error;
+    error.errorCode = MEDIA_MSG_ERR_LOAD;
+    error.errorText = "Failed to acquire resources for " + uri_;
+    if (cbFunction_)
+      cbFunction_(NOTIFY_ERROR, 0, nullptr, &error);
+    return;
+  }
+
+  NotifySourceInfo();
+  if (scaled_video_sink_)
+    SetScaledVideoSize();
+  UnblockDecoders();
+}
+
+void UriPlayer::HandleStreamsSelected(GstMessage *message) {
+  std::lock_guard<std::recursive_mutex> lock(recursive_mutex_);
+  selected_streams_.clear();
+
+  guint size = gst_message_streams_selected_get_size(message);
+  for (guint i = 0; i < size; i++) {
+    GstStream *stream = gst_message_streams_selected_get_stream(message, i);
+    GMP_DEBUG_PRINT("selected stream: %s", gst_stream_get_stream_id(stream));
+    selected_streams_.push_back(gst_stream_get_stream_id(stream));
+    gst_object_unref(stream);
+  }
+}
+
+// Holds everything after stream-start, the decoder must not see caps
+// before its resources are acquired.
+void UriPlayer::BlockDecoder(GstElement *decoder) {
+  std::lock_guard<std::mutex> lock(blocked_pads_lock_);
+  if (source_info_ready_)
+    return;
+
+  GstPad *pad = gst_element_get_static_pad(decoder, "sink");
+  if (!pad)
+    return;
+
+  gulong id = gst_pad_add_probe(pad, (GstPadProbeType)(
+      GST_PAD_PROBE_TYPE_BLOCK | GST_PAD_PROBE_TYPE_DATA_DOWNSTREAM),
+      +[] (GstPad *pad, GstPadProbeInfo *info, gpointer data) -> GstPadProbeReturn {
+        if ((info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) &&
+            GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info)) == GST_EVENT_STREAM_START)
+          return GST_PAD_PROBE_PASS;
+        return GST_PAD_PROBE_OK;
+      }, NULL, NULL);
+  GMP_DEBUG_PRINT("block %s until resources are acquired",
+                  GST_ELEMENT_NAME(decoder));
+  blocked_pads_.emplace_back(pad, id);
+}
+
+void UriPlayer::UnblockDecoders() {
+  std::lock_guard<std::mutex> lock(blocked_pads_lock_);
+  for (auto &blocked : blocked_pads_) {
+    gst_pad_remove_probe(blocked.first, blocked.second);
+    gst_object_unref(blocked.first);
+  }
+  blocked_pads_.clear();
 }
 
 bool UriPlayer::UnloadImpl() {
   GMP_DEBUG_PRINT("unload");
 
-  if (queue2_)
+  UnregisterMemoryBudget();
+
+  if (queue2_) {
     g_object_unref(queue2_);
+    queue2_ = nullptr;
+  }
 
   if (bufferingTimer_id_) {
     g_source_remove(bufferingTimer_id_);
     bufferingTimer_id_ = 0;
   }
   current_position_ = 0;
+  source_info_ready_ = false;
+  scaled_video_sink_ = false;
+  use_playbin3_ = false;
+  gst_object_replace(reinterpret_cast<GstObject **>(&collection_), NULL);
+  selected_streams_.clear();
 
   SetPlayerState(base::playback_state_t::STOPPED);
 
@@ -115,6 +327,13 @@ bool UriPlayer::UnloadImpl() {
 
 bool UriPlayer::Play() {
   GMP_DEBUG_PRINT("play");
+  std::lock_guard<std::recursive_mutex> lock(recursive_mutex_);
+  if (discoverer_) {
+    GMP_DEBUG_PRINT("discovery in progress, play after load");
+    pending_state_ = base::playback_state_t::PLAYING;
+    return true;
+  }
+
   if (!pipeline_) {
     GMP_DEBUG_PRINT("pipeline is null");
     return false;
@@ -126,7 +345,6 @@ bool UriPlayer::Play() {
     return true;
   }
 
-  std::lock_guard<std::recursive_mutex> lock(recursive_mutex_);
   if (!buffering_) {
     if (!gst_element_set_state(pipeline_, GST_STATE_PLAYING))
       return false;
@@ -142,6 +360,13 @@ bool UriPlayer::Play() {
 
 bool UriPlayer::Pause() {
   GMP_DEBUG_PRINT("pause");
+  std::lock_guard<std::recursive_mutex> lock(recursive_mutex_);
+  if (discoverer_) {
+    GMP_DEBUG_PRINT("discovery in progress, pause after load");
+    pending_state_ = base::playback_state_t::PAUSED;
+    return true;
+  }
+
   if (!pipeline_) {
     GMP_DEBUG_PRINT("pipeline is null");
     return false;
@@ -179,6 +404,11 @@ bool UriPlayer::SetPlayRate(const double rate) {
     return true;
   }
 
+  // the position timer doesn't run while paused
+  gint64 pos = 0;
+  if (gst_element_query_position(pipeline_, GST_FORMAT_TIME, &pos))
+    current_position_ = pos;
+
   if (current_position_ < 0) {
     GMP_DEBUG_PRINT("current_postion is less than 0");
     return false;
@@ -213,6 +443,12 @@ bool UriPlayer::Seek(const int64_t msecond) {
   GMP_DEBUG_PRINT("Seek:  %" G_GINT64_FORMAT, msecond);
   std::lock_guard<std::recursive_mutex> lock(recursive_mutex_);
 
+  if (discoverer_) {
+    GMP_DEBUG_PRINT("discovery in progress, seek after load");
+    SetReloading(msecond);
+    return true;
+  }
+
   if (!pipeline_) {
     GMP_DEBUG_PRINT("pipeline is null");
     return false;
@@ -225,6 +461,83 @@ bool UriPlayer::Seek(const int64_t msecond) {
                    GST_SEEK_TYPE_NONE, 0);
 }
 
+// playbin3 switches with a select-streams event, so only the selected
+// streams are decoded. playbin decodes every stream and switches its
+// input-selector.
+bool UriPlayer::SelectTrack(const std::string &type, int32_t index) {
+  GMP_DEBUG_PRINT("SelectTrack: type(%s), index(%d)", type.c_str(), index);
+  std::lock_guard<std::recursive_mutex> lock(recursive_mutex_);
+
+  if (!pipeline_) {
+    GMP_DEBUG_PRINT("pipeline is null");
+    return false;
+  }
+
+  GstStreamType streamType;
+  const char *current = nullptr;
+  const char *count = nullptr;
+  if (type == "video") {
+    streamType = GST_STREAM_TYPE_VIDEO;
+    current = "current-video";
+    count = "n-video";
+  } else if (type == "audio") {
+    streamType = GST_STREAM_TYPE_AUDIO;
+    current = "current-audio";
+    count = "n-audio";
+  } else if (type == "text") {
+    streamType = GST_STREAM_TYPE_TEXT;
+    current = "current-text";
+    count = "n-text";
+  } else {
+    GMP_DEBUG_PRINT("unknown track type %s", type.c_str());
+    return false;
+  }
+
+  if (!use_playbin3_) {
+    gint streams = 0;
+    g_object_get(G_OBJECT(pipeline_), count, &streams, NULL);
+    if (index < 0 || index >= streams) {
+      GMP_DEBUG_PRINT("%s track %d out of %d", type.c_str(), index, streams);
+      return false;
+    }
+    g_object_set(G_OBJECT(pipeline_), current, index, NULL);
+    return true;
+  }
+
+  if (!collection_) {
+    GMP_DEBUG_PRINT("no stream collection yet");
+    return false;
+  }
+
+  // the streams selected for the other types stay selected
+  GList *streams = NULL;
+  const gchar *selected = NULL;
+  gint32 n = 0;
+  for (guint i = 0; i < gst_stream_collection_get_size(collection_); i++) {
+    GstStream *stream = gst_stream_collection_get_stream(collection_, i);
+    const gchar *id = gst_stream_get_stream_id(stream);
+    if (gst_stream_get_stream_type(stream) & streamType) {
+      if (n++ == index)
+        selected = id;
+    } else if (std::find(selected_streams_.begin(), selected_streams_.end(),
+                         id) != selected_streams_.end()) {
+      streams = g_list_append(streams, const_cast<gchar *>(id));
+    }
+  }
+
+  if (!selected) {
+    GMP_DEBUG_PRINT("%s track %d out of %d", type.c_str(), index, n);
+    g_list_free(streams);
+    return false;
+  }
+
+  streams = g_list_append(streams, const_cast<gchar *>(selected));
+  bool ret = gst_element_send_event(pipeline_,
+                                    gst_event_new_select_streams(streams));
+  g_list_free(streams);
+  return ret;
+}
+
 bool UriPlayer::SetVolume(int volume) {
   GMP_DEBUG_PRINT("SetVolume: volume(%d)", volume);
 
@@ -241,30 +554,22 @@ bool UriPlayer::SetVolume(int volume) {
   return ret;
 }
 
-bool UriPlayer::GetSourceInfo() {
-  GError *err = NULL;
-  GstDiscoverer* discoverer = NULL;
-  GstDiscovererInfo* info = NULL;
-  uint64_t duration = 0;
-  discoverer = gst_discoverer_new((GstClockTime)DISCOVER_EXPIRE_TIME, &err);
-  info = gst_discoverer_discover_uri(discoverer, uri_.c_str(), &err);
-  duration = gst_discoverer_info_get_duration(info);
+bool UriPlayer::GetSourceInfo(GstDiscovererInfo *info) {
+  uint64_t duration = gst_discoverer_info_get_duration(info);
+  source_info_ = base::source_info_t();
 
   GList *video_info = gst_discoverer_info_get_video_streams(info);
   GList *audio_info = gst_discoverer_info_get_audio_streams(info);
 
-  base::video_info_t video_stream_info = {};
-  base::audio_info_t audio_stream_info = {};
-
   if (!video_info && !audio_info) {
     GMP_DEBUG_PRINT("Failed to get A/V info from stream");
     return false;
   }
 
-  if (video_info) {
-    GList *first = g_list_first(video_info);
+  for (GList *item = video_info; item; item = item->next) {
     GstDiscovererVideoInfo *video
-      = reinterpret_cast<GstDiscovererVideoInfo *>(first->data);
+      = reinterpret_cast<GstDiscovererVideoInfo *>(item->data);
+    base::video_info_t video_stream_info;
 
     video_stream_info.width = gst_discoverer_video_info_get_width(video);
     video_stream_info.height = gst_discoverer_video_info_get_height(video);
@@ -272,52 +577,142 @@ bool UriPlayer::GetSourceInfo() {
     video_stream_info.bit_rate = gst_discoverer_video_info_get_bitrate(video);
     video_stream_info.frame_rate.num = gst_discoverer_video_info_get_framerate_num(video);
     video_stream_info.frame_rate.den = gst_discoverer_video_info_get_framerate_denom(video);
-    GMP_DEBUG_PRINT("[video info] width: %d, height: %d, bitRate : %" PRIu64 ", frameRate: %d/%d",
+    GMP_DEBUG_PRINT("[video info %zu] width: %d, height: %d, bitRate : %" PRIu64 ", frameRate: %d/%d",
+                   source_info_.video_streams.size(),
                    video_stream_info.width,
                    video_stream_info.height,
                    video_stream_info.bit_rate,
                    video_stream_info.frame_rate.num,
                    video_stream_info.frame_rate.den);
-  } else {
-    GMP_DEBUG_PRINT("Failed to get video info from stream");
+    source_info_.video_streams.push_back(video_stream_info);
   }
 
-  if (audio_info) {
-    GList *first = g_list_first(audio_info);
+  for (GList *item = audio_info; item; item = item->next) {
     GstDiscovererAudioInfo *audio
-      = reinterpret_cast<GstDiscovererAudioInfo *>(first->data);
+      = reinterpret_cast<GstDiscovererAudioInfo *>(item->data);
+    base::audio_info_t audio_stream_info;
+
     audio_stream_info.codec = 0;
     audio_stream_info.bit_rate = gst_discoverer_audio_info_get_bitrate(audio);
     audio_stream_info.sample_rate
       = gst_discoverer_audio_info_get_sample_rate(audio);
-    GMP_DEBUG_PRINT("[audio info] bitRate: %" PRIu64 "sampleRate: %d",
+    audio_stream_info.channels = gst_discoverer_audio_info_get_channels(audio);
+    GMP_DEBUG_PRINT("[audio info %zu] bitRate: %" PRIu64 " sampleRate: %d, channels: %d",
+                   source_info_.audio_streams.size(),
                    audio_stream_info.bit_rate,
-                   audio_stream_info.sample_rate);
-  } else {
+                   audio_stream_info.sample_rate,
+                   audio_stream_info.channels);
+    source_info_.audio_streams.push_back(audio_stream_info);
+  }
+
+  // the playback paths expect a video and an audio entry
+  if (source_info_.video_streams.empty()) {
+    GMP_DEBUG_PRINT("Failed to get video info from stream");
+    source_info_.video_streams.push_back(base::video_info_t());
+  }
+  if (source_info_.audio_streams.empty()) {
     GMP_DEBUG_PRINT("Failed to get audio info from stream");
+    source_info_.audio_streams.push_back(base::audio_info_t());
   }
+
   duration_ = duration;
   source_info_.duration = GST_TIME_AS_MSECONDS(duration);
   source_info_.seekable = true;
 
-  // TODO(anonymous): Support multi-track media case.
+  // One program, the first stream of each type is played by default.
   base::program_info_t program;
   program.audio_stream = 1;
   program.video_stream = 1;
   source_info_.programs.push_back(program);
 
-  source_info_.video_streams.push_back(video_stream_info);
-  source_info_.audio_streams.push_back(audio_stream_info);
-
-  GMP_DEBUG_PRINT("Width: : %d", video_stream_info.width);
-  GMP_DEBUG_PRINT("Height: : %d", video_stream_info.height);
-  GMP_DEBUG_PRINT("Duration: :%" PRIu64, duration);
+  GMP_DEBUG_PRINT("Streams: video %zu, audio %zu, Duration: %" PRIu64,
+                  source_info_.video_streams.size(),
+                  source_info_.audio_streams.size(), duration);
 
-  g_clear_error(&err);
   gst_discoverer_stream_info_list_free(video_info);
   gst_discoverer_stream_info_list_free(audio_info);
-  g_object_unref(discoverer);
-  g_object_unref(info);
+  return true;
+}
+
+bool UriPlayer::GetSourceInfo(GstStreamCollection *collection) {
+  base::source_info_t source_info;
+  guint size = gst_stream_collection_get_size(collection);
+
+  for (guint i = 0; i < size; i++) {
+    GstStream *stream = gst_stream_collection_get_stream(collection, i);
+    GstStreamType type = gst_stream_get_stream_type(stream);
+    if (!(type & (GST_STREAM_TYPE_VIDEO | GST_STREAM_TYPE_AUDIO)))
+      continue;
+
+    guint bitrate = 0;
+    GstTagList *tags = gst_stream_get_tags(stream);
+    if (tags) {
+      if (!gst_tag_list_get_uint(tags, GST_TAG_BITRATE, &bitrate))
+        gst_tag_list_get_uint(tags, GST_TAG_NOMINAL_BITRATE, &bitrate);
+      gst_tag_list_unref(tags);
+    }
+
+    GstCaps *caps = gst_stream_get_caps(stream);
+    const GstStructure *s =
+        (caps && !gst_caps_is_empty(caps)) ? gst_caps_get_structure(caps, 0) : NULL;
+
+    if (type & GST_STREAM_TYPE_VIDEO) {
+      base::video_info_t video_stream_info;
+      gint width = 0, height = 0, fps_n = 0, fps_d = 1;
+      if (s) {
+        gst_structure_get_int(s, "width", &width);
+        gst_structure_get_int(s, "height", &height);
+        gst_structure_get_fraction(s, "framerate", &fps_n, &fps_d);
+      }
+      video_stream_info.width = width;
+      video_stream_info.height = height;
+      video_stream_info.bit_rate = bitrate;
+      video_stream_info.frame_rate.num = fps_n;
+      video_stream_info.frame_rate.den = fps_d;
+      GMP_DEBUG_PRINT("[video stream] width: %d, height: %d, bitRate : %u, frameRate: %d/%d",
+                      width, height, bitrate, fps_n, fps_d);
+      source_info.video_streams.push_back(video_stream_info);
+    } else {
+      base::audio_info_t audio_stream_info;
+      gint rate = 0, channels = 0;
+      if (s) {
+        gst_structure_get_int(s, "rate", &rate);
+        gst_structure_get_int(s, "channels", &channels);
+      }
+      audio_stream_info.bit_rate = bitrate;
+      audio_stream_info.sample_rate = rate;
+      audio_stream_info.channels = channels;
+      GMP_DEBUG_PRINT("[audio stream] bitRate: %u, sampleRate: %d", bitrate, rate);
+      source_info.audio_streams.push_back(audio_stream_info);
+    }
+
+    if (caps)
+      gst_caps_unref(caps);
+  }
+
+  if (source_info.video_streams.empty() && source_info.audio_streams.empty())
+    return false;
+
+  // the playback paths expect a video and an audio entry
+  if (source_info.video_streams.empty())
+    source_info.video_streams.push_back(base::video_info_t());
+  if (source_info.audio_streams.empty())
+    source_info.audio_streams.push_back(base::audio_info_t());
+
+  gint64 duration = 0;
+  if (pipeline_ &&
+      gst_element_query_duration(pipeline_, GST_FORMAT_TIME, &duration))
+    duration_ = duration;
+  source_info.duration = GST_TIME_AS_MSECONDS(duration_);
+  source_info.seekable = true;
+
+  // One program, the first stream of each type is played by default.
+  base::program_info_t program;
+  program.audio_stream = 1;
+  program.video_stream = 1;
+  source_info.programs.push_back(program);
+
+  source_info_ = source_info;
   return true;
 }
 
@@ -346,6 +741,21 @@ gboolean UriPlayer::HandleBusMessage(GstBus *bus,
       break;
     }
 
+    case GST_MESSAGE_STREAM_COLLECTION: {
+      GstStreamCollection *collection = NULL;
+      gst_message_parse_stream_collection(message, &collection);
+      if (collection) {
+        player->HandleStreamCollection(collection);
+        gst_object_unref(collection);
+      }
+      break;
+    }
+
+    case GST_MESSAGE_STREAMS_SELECTED: {
+      player->HandleStreamsSelected(message);
+      break;
+    }
+
     case GST_MESSAGE_EOS: {
       GMP_DEBUG_PRINT("Got endOfStream");
       if (player->cbFunction_)
@@ -411,6 +821,12 @@ gboolean UriPlayer::HandleBusMessage(GstBus *bus,
           GST_DEBUG_BIN_TO_DOT_FILE_WITH_TS(GST_BIN (pipeline),
                 GST_DEBUG_GRAPH_SHOW_ALL, dump_name.c_str());
         }
+
+        std::lock_guard<std::recursive_mutex> lock(player->recursive_mutex_);
+        if (new_state == GST_STATE_PLAYING)
+          player->StartPositionTimer();
+        else if (old_state == GST_STATE_PLAYING)
+          player->StopPositionTimer();
       }
       break;
     }
@@ -544,12 +960,42 @@ drop:
   return GST_BUS_DROP;
 }
 
+// queue2 may not exist yet, element-setup picks up the limit then.
+void UriPlayer::SetMemoryLimit(guint64 limit) {
+  queue2LimitBytes_ = (gint)MIN(limit, (guint64)queue2MaxSizeBytes);
+  GMP_INFO_PRINT("queue2 max-size-bytes -> %d", (gint)queue2LimitBytes_);
+
+  if (queue2_)
+    g_object_set(queue2_, "max-size-bytes", (guint)queue2LimitBytes_, NULL);
+}
+
+// MemoryBudget may ask while another thread holds our lock, the last
+// reading is returned then instead of waiting.
+guint64 UriPlayer::GetMemoryUsage() {
+  std::unique_lock<std::recursive_mutex> lock(recursive_mutex_,
+                                              std::try_to_lock);
+  if (!lock.owns_lock())
+    return queue2Usage_;
+
+  guint usage = 0;
+  if (queue2_)
+    g_object_get(queue2_, "current-level-bytes", &usage, NULL);
+  queue2Usage_ = usage;
+  return usage;
+}
+
 bool UriPlayer::LoadPipeline() {
   GMP_DEBUG_PRINT("LoadPipeline planeId:%d", planeId_);
 
-  NotifySourceInfo();
+  if (!skip_discovery_)
+    NotifySourceInfo();
 
-  pipeline_ = gst_element_factory_make("playbin", "playbin");
+  // Only playbin3 posts the stream collection the source info comes from,
+  // and only playbin3 leaves unselected tracks undecoded.
+  use_playbin3_ = skip_discovery_ || source_info_.video_streams.size() > 1 ||
+                  source_info_.audio_streams.size() > 1;
+  pipeline_ = gst_element_factory_make(use_playbin3_ ? "playbin3" : "playbin",
+                                       "playbin");
 
   if (!pipeline_) {
     GMP_DEBUG_PRINT("ERROR : Cannot create pipeline!");
@@ -573,9 +1019,15 @@ bool UriPlayer::LoadPipeline() {
     if (g_strrstr(name, "queue2") != NULL) {
       player->queue2_ = GST_ELEMENT_CAST(gst_object_ref(element));
       GMP_INFO_PRINT("%s element set for the max_size_time property!", name);
-      g_object_set(element, "max-size-bytes", player->queue2MaxSizeBytes,
+      g_object_set(element, "max-size-bytes", (guint)player->queue2LimitBytes_,
                             "max-size-time", player->queue2MaxSizeTime, NULL);
     }
+
+    GstElementFactory *factory = gst_element_get_factory(element);
+    if (player->skip_discovery_ && factory &&
+        gst_element_factory_list_is_type(factory,
+                                         GST_ELEMENT_FACTORY_TYPE_DECODER))
+      player->BlockDecoder(element);
     g_free(name);
   };
 
@@ -611,10 +1063,9 @@ bool UriPlayer::LoadPipeline() {
         return false;
       }
 
-      gint scale_width = VIDEO_SCALE_WIDTH;
-      gint scale_height = (source_info_.video_streams[0].height * scale_width) /
-                         source_info_.video_streams[0].width;
-      lsm_connector_.setVideoSize(scale_width, scale_height);
+      scaled_video_sink_ = true;
+      if (!skip_discovery_)
+        SetScaledVideoSize();
 
       gst_bin_add_many(GST_BIN(vSink), videoConvert, capsFilter, videoSink, NULL);
       if (!gst_element_link_many(videoConvert, capsFilter, videoSink, NULL)) {
@@ -655,6 +1106,17 @@ bool UriPlayer::LoadPipeline() {
   return gst_element_set_state(pipeline_, GST_STATE_PAUSED);
 }
 
+void UriPlayer::SetScaledVideoSize() {
+  gint scale_width = VIDEO_SCALE_WIDTH;
+  gint scale_height = VIDEO_SCALE_HEIGHT;
+  // audio only streams report a zero sized video stream
+  if (!source_info_.video_streams.empty() &&
+      source_info_.video_streams[0].width > 0)
+    scale_height = (source_info_.video_streams[0].height * scale_width) /
+                   source_info_.video_streams[0].width;
+  lsm_connector_.setVideoSize(scale_width, scale_height);
+}
+
 gboolean UriPlayer::NotifyCurrentTime(gpointer user_data) {
   UriPlayer *player = reinterpret_cast<UriPlayer *>(user_data);
   std::lock_guard<std::recursive_mutex> lock(player->recursive_mutex_);
@@ -667,6 +1129,8 @@ gboolean UriPlayer::NotifyCurrentTime(gpointer user_data) {
     return true;
   }
 
+  if (pos == player->current_position_)
+    return true;
   player->current_position_ = pos;
 
   pos = GST_TIME_AS_MSECONDS(pos);
@@ -832,35 +1296,20 @@ int32_t UriPlayer::ConvertErrorCode(GQuark domain, gint code) {
   return converted;
 }
 
-void UriPlayer::ParseOptionString(const std::string &str) {
-  GMP_DEBUG_PRINT("option string: %s", str.c_str());
-
-  pbnjson::JDomParser jdparser;
-  if (!jdparser.parse(str, pbnjson::JSchema::AllSchema())) {
-    GMP_DEBUG_PRINT("ERROR JDomParser.parse. msg: %s ", str.c_str());
-    return;
-  }
-  pbnjson::JValue parsed = jdparser.getDom();
-
-  if(parsed.hasKey("uri")) {
-    uri_ = parsed["uri"].asString();
-  }
-  else {
+void UriPlayer::SetLoadParam(const base::load_param_t &param) {
+  if (!param.uri.empty()) {
+    uri_ = param.uri;
+  } else {
     GMP_DEBUG_PRINT("UMS_INTERNAL_API_VERSION is not version 2.");
     GMP_DEBUG_PRINT("Please check the UMS_INTERNAL_API_VERSION in ums.");
     GMPASSERT(0);
   }
 
-  if (parsed["options"]["option"].hasKey("displayPath")) {
-    int32_t display_path = parsed["options"]["option"]["displayPath"].asNumber<int32_t>();
-    display_path_ = (display_path > SECONDARY_DISPLAY ? 0 : display_path);
-  }
-  if (parsed["options"]["option"].hasKey("windowId")) {
-    window_id_ = parsed["options"]["option"]["windowId"].asString();
-  }
-  if (parsed["options"]["option"].hasKey("videoDisplayMode")) {
-    display_mode_ = parsed["options"]["option"]["videoDisplayMode"].asString();
-  }
+  display_path_ = (param.displayPath > SECONDARY_DISPLAY ? 0 : param.displayPath);
+  if (!param.windowId.empty())
+    window_id_ = param.windowId;
+  if (!param.videoDisplayMode.empty())
+    display_mode_ = param.videoDisplayMode;
 
   GMP_DEBUG_PRINT("uri: %s, display-path: %d, window_id: %s, display_mode: %s",
     uri_.c_str(), display_path_, window_id_.c_str(), display_mode_.c_str());
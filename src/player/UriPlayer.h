@@ -18,6 +18,12 @@
 #ifndef SRC_PLAYER_URI_PLAYER_H_
 #define SRC_PLAYER_URI_PLAYER_H_
 
+#include <atomic>
+#include <utility>
+#include <vector>
+
+#include <gst/pbutils/pbutils.h>
+
 #include "AbstractPlayer.h"
 
 namespace gmp { namespace player {
@@ -25,24 +31,42 @@ namespace gmp { namespace player {
 class UriPlayer : public AbstractPlayer {
  public:
   ~UriPlayer();
-  bool Load(const std::string &str) override;
+  bool Load(const base::load_param_t &param) override;
+  bool Unload() override;
   bool UnloadImpl() override;
   bool Play() override;
   bool Pause() override;
   bool SetPlayRate(const double rate) override;
   bool Seek(const int64_t position) override;
+  bool SelectTrack(const std::string &type, int32_t index) override;
   bool SetVolume(int volume) override;
+  guint64 GetMemoryUsage() override;
   static gboolean HandleBusMessage(GstBus *bus,
                                    GstMessage *message, gpointer user_data);
   static GstBusSyncReply HandleSyncBusMessage(GstBus * bus,
                                    GstMessage * msg, gpointer data);
   static gboolean NotifyCurrentTime(gpointer user_data);
   static gboolean NotifyBufferingTime(gpointer user_data);
+  static void HandleDiscovered(GstDiscoverer *discoverer,
+                               GstDiscovererInfo *info,
+                               GError *err, gpointer user_data);
 
  protected:
   UriPlayer();
   void NotifySourceInfo();
-  bool GetSourceInfo();
+  bool StartDiscovery();
+  void CancelDiscovery();
+  bool GetSourceInfo(GstDiscovererInfo *info);
+  bool GetSourceInfo(GstStreamCollection *collection);
+  bool CompleteLoad();
+  bool LoadWithoutDiscovery();
+  bool AcquireResources();
+  void StartLoadedTimers();
+  void HandleStreamCollection(GstStreamCollection *collection);
+  void HandleStreamsSelected(GstMessage *message);
+  void BlockDecoder(GstElement *decoder);
+  void UnblockDecoders();
+  void SetScaledVideoSize();
   virtual bool LoadPipeline();
   base::error_t HandleErrorMessage(GstMessage *message);
   int32_t ConvertErrorCode(GQuark domain, gint code);
@@ -56,11 +80,26 @@ class UriPlayer : public AbstractPlayer {
     current_state_ = state;
     return true;
   }
-  void ParseOptionString(const std::string &str);
+  void SetLoadParam(const base::load_param_t &param);
+  void SetMemoryLimit(guint64 limit) override;
 
   std::string uri_ = "";
   std::string connectID_;
   bool httpSource_ = false;
+  GstDiscoverer *discoverer_ = nullptr;  // set while discovery is in flight
+  base::playback_state_t pending_state_ = base::playback_state_t::STOPPED;
+
+  /* skip discovery mode */
+  bool skip_discovery_ = false;
+  std::atomic<bool> source_info_ready_ { false };
+  bool scaled_video_sink_ = false;
+  std::mutex blocked_pads_lock_;
+  std::vector<std::pair<GstPad *, gulong>> blocked_pads_;
+
+  /* track selection, the collection is only posted by playbin3 */
+  bool use_playbin3_ = false;
+  GstStreamCollection *collection_ = nullptr;
+  std::vector<std::string> selected_streams_;
   mutable std::mutex state_lock_;
 
   /* buffering variable */
@@ -71,6 +110,8 @@ class UriPlayer : public AbstractPlayer {
   gint64 buffered_time_ = -1;
   base::playback_state_t current_state_ = base::playback_state_t::STOPPED;
   const gint queue2MaxSizeBytes = 24 * 1024 * 1024;
+  std::atomic<gint> queue2LimitBytes_ { queue2MaxSizeBytes };
+  std::atomic<guint64> queue2Usage_ { 0 };
   const gint64 queue2MaxSizeTime = 10 * GST_SECOND;
   const gint64 queue2MaxSizeMsec = GST_TIME_AS_MSECONDS(queue2MaxSizeTime);
   const gint audioQueue2MaxSizeBytes = 4 * 1024 * 1024;
@@ -15,6 +15,7 @@
 
 // SPDX-License-Identifier: Apache-2.0
 
+#include <sys/stat.h>
 #include <gst/gst.h>
 
 #include "ElementFactory.h"
@@ -25,107 +26,277 @@ namespace gmp { namespace pf {
 
 const char ElementFactory::gst_element_json_path[] = "/etc/g-media-pipeline/gst_elements.conf";
 
-GstElement * ElementFactory::Create(const std::string &pipelineType,
-  const std::string &elementTypeName, uint32_t displayPath) {
-  GstElement * element = GetGstElement(pipelineType, elementTypeName);
-  pbnjson::JValue root = pbnjson::JDomParser::fromFile(gst_element_json_path);
-  if (!root.isObject()) {
-    GMP_DEBUG_PRINT("Gst element file parsing error");
-    return NULL;
-  }
+std::mutex ElementFactory::configLock_;
+std::shared_ptr<const ELEMENT_FACTORY_CONFIG_T> ElementFactory::config_;
 
-  pbnjson::JValue elements = root["gst_elements"];
-  int i = GetPipelineType(pipelineType);
-  if (elements[i].hasKey(elementTypeName)
-    && elements[i][elementTypeName].hasKey("name")) {
-    if (elements[i][elementTypeName].hasKey("properties")) {
-      for(auto it : elements[i][elementTypeName]["properties"].children()) {
-        SetProperty(element, it.first, it.second);
-      }
-    }
+// GMP_GST_ELEMENTS_CONF lets tests run against their own element table.
+const char * ElementFactory::GetConfigPath() {
+  const char *path = g_getenv("GMP_GST_ELEMENTS_CONF");
+  if (path && *path)
+    return path;
+  return gst_element_json_path;
+}
 
-    if (elements[i][elementTypeName].hasKey("device")) {
-      pbnjson::JValue el = elements[i][elementTypeName]["device"];
-      if (el.isArray() && displayPath < el.arraySize()
-        && el[displayPath].isString()) {
-        GMP_DEBUG_PRINT("Select device %d - name : %s",
-          displayPath, el[displayPath].asString().c_str());
-        SetProperty(element, "device", el[displayPath].asString());
-      }
-    }
-  } else {
-    GMP_DEBUG_PRINT("elementTypeName : %s is not exist",
-      elementTypeName.c_str());
-  }
+ElementProperty::ElementProperty(const std::string &name, const GValue *value)
+  : name_(name) {
+  g_value_init(&value_, G_VALUE_TYPE(value));
+  g_value_copy(value, &value_);
+}
 
-  return element;
+ElementProperty::ElementProperty(const ElementProperty &other)
+  : name_(other.name_) {
+  g_value_init(&value_, G_VALUE_TYPE(&other.value_));
+  g_value_copy(&other.value_, &value_);
 }
 
-gint32 ElementFactory::GetUseAudioProperty() {
-  gint32 ret = 1;
-  pbnjson::JValue root = pbnjson::JDomParser::fromFile(gst_element_json_path);
-  if (!root.isObject()) {
-    GMP_DEBUG_PRINT("Gst element file parsing error");
-    return ret;
-  }
+ElementProperty & ElementProperty::operator=(const ElementProperty &other) {
+  if (this == &other)
+    return *this;
+  name_ = other.name_;
+  g_value_unset(&value_);
+  g_value_init(&value_, G_VALUE_TYPE(&other.value_));
+  g_value_copy(&other.value_, &value_);
+  return *this;
+}
 
-  if (root.hasKey("use_audio")) {
-    ret = root["use_audio"].asNumber<int32_t>();
-  }
+ElementProperty::~ElementProperty() {
+  g_value_unset(&value_);
+}
 
-  return ret;
+void ElementProperty::Apply(GstElement *element) const {
+  g_object_set_property(G_OBJECT(element), name_.c_str(), &value_);
 }
 
-std::string ElementFactory::GetPlatform(void)
-{
-  pbnjson::JValue root = pbnjson::JDomParser::fromFile(gst_element_json_path);
-  std::string strReturn = std::string("");
+// A config parsed before gst_init can't resolve factories, redo it once
+// gstreamer is up.
+std::shared_ptr<const ELEMENT_FACTORY_CONFIG_T> ElementFactory::GetConfig() {
+  std::lock_guard<std::mutex> lock(configLock_);
+  if (!config_ || (!config_->resolved && gst_is_initialized()))
+    config_ = ParseConfig(GetConfigPath());
+  return config_;
+}
 
-  if (!root.isObject()) {
-    GMP_DEBUG_PRINT("Gst element file parsing error");
+bool ElementFactory::Reload() {
+  std::shared_ptr<const ELEMENT_FACTORY_CONFIG_T> config = ParseConfig(GetConfigPath());
+
+  std::lock_guard<std::mutex> lock(configLock_);
+  config_ = config;
+  return config->valid;
+}
+
+bool ElementFactory::ReloadIfChanged() {
+  const char *path = GetConfigPath();
+  std::shared_ptr<const ELEMENT_FACTORY_CONFIG_T> config;
+  {
+    std::lock_guard<std::mutex> lock(configLock_);
+    config = config_;
   }
 
-  pbnjson::JValue jvPlatform = root["platform"];
-  if (!jvPlatform.isString()) {
-    GMP_DEBUG_PRINT("Please check the json file in %s", gst_element_json_path);
-  } else {
-    strReturn = root["platform"].asString();
-    GMP_DEBUG_PRINT("Platform : %s", strReturn.c_str());
+  if (config && config->path == path) {
+    struct stat st;
+    time_t mtime = 0;
+    off_t size = 0;
+    if (stat(path, &st) == 0) {
+      mtime = st.st_mtime;
+      size = st.st_size;
+    }
+    if (mtime == config->mtime && size == config->size)
+      return false;
   }
-  return strReturn;
+
+  GMP_DEBUG_PRINT("Reload %s", path);
+  Reload();
+  return true;
 }
 
-std::string ElementFactory::GetPreferredElementName(const std::string &pipelineType,
-  const std::string & elementTypeName) {
-  std::string elementName = std::string("");
-  pbnjson::JValue root = pbnjson::JDomParser::fromFile(gst_element_json_path);
+std::shared_ptr<const ELEMENT_FACTORY_CONFIG_T> ElementFactory::ParseConfig(const char *path) {
+  std::shared_ptr<ELEMENT_FACTORY_CONFIG_T> config =
+      std::make_shared<ELEMENT_FACTORY_CONFIG_T>();
+  config->path = path;
+  config->mtime = 0;
+  config->size = 0;
+  config->valid = false;
+  config->resolved = false;
+  config->useAudio = 1;
+  config->memoryBudgetMb = 0;
+  config->allowNoWindow = false;
+  config->pipelinePoolSize = 0;
+  config->pipelinePoolReady = false;
+  config->discoveryCacheSize = 64;
+  config->skipDiscovery = false;
+  config->notifyMinIntervalMs = 100;
+
+  struct stat st;
+  if (stat(path, &st) == 0) {
+    config->mtime = st.st_mtime;
+    config->size = st.st_size;
+  }
+
+  pbnjson::JValue root = pbnjson::JDomParser::fromFile(path);
   if (!root.isObject()) {
     GMP_DEBUG_PRINT("Gst element file parsing error");
-    return std::string("");
+    return config;
   }
+  config->valid = true;
+
+  if (root["platform"].isString())
+    config->platform = root["platform"].asString();
+  else
+    GMP_DEBUG_PRINT("Please check the json file in %s", path);
+
+  if (root.hasKey("use_audio"))
+    config->useAudio = root["use_audio"].asNumber<int32_t>();
+
+  // Total bytes all players may queue, in MB.
+  if (root.hasKey("memory_budget_mb"))
+    config->memoryBudgetMb = root["memory_budget_mb"].asNumber<int64_t>();
+
+  // Lets a pipeline with video load without a window, e.g. with fakesink.
+  if (root.hasKey("allow_no_window"))
+    config->allowNoWindow = root["allow_no_window"].asBool();
+
+  // Idle BufferPlayer pipelines kept for reuse, 0 disables the pool.
+  if (root.hasKey("pipeline_pool_size"))
+    config->pipelinePoolSize = root["pipeline_pool_size"].asNumber<int32_t>();
+
+  // The decoders release their hardware in READY, pooled pipelines may stay
+  // there instead of going to NULL.
+  if (root.hasKey("pipeline_pool_ready"))
+    config->pipelinePoolReady = root["pipeline_pool_ready"].asBool();
+
+  // Discovered local files remembered across loads, 0 disables the cache.
+  if (root.hasKey("discovery_cache_size"))
+    config->discoveryCacheSize = root["discovery_cache_size"].asNumber<int32_t>();
+
+  // UriPlayer takes the source info from playbin3 instead of a discoverer.
+  if (root.hasKey("skip_discovery"))
+    config->skipDiscovery = root["skip_discovery"].asBool();
+
+  // Repeats of a coalesced notification are held back this long, 0 sends all.
+  if (root.hasKey("notify_min_interval_ms"))
+    config->notifyMinIntervalMs = root["notify_min_interval_ms"].asNumber<int32_t>();
 
   pbnjson::JValue elements = root["gst_elements"];
-  int i = GetPipelineType(pipelineType);
-  if (elements[i].hasKey(elementTypeName)
-    && elements[i][elementTypeName].hasKey("name")) {
-    elementName = elements[i][elementTypeName]["name"].asString();
-    GMP_DEBUG_PRINT("%s : %s", elementTypeName.c_str(), elementName.c_str());
-  } else {
+  for (gint32 i = 0; elements.isArray() && i < elements.arraySize(); ++i) {
+    for (auto it : elements[i].children()) {
+      if (!it.first.isString() || !it.second.isObject()
+        || !it.second.hasKey("name"))
+        continue;
+
+      ELEMENT_CONFIG_T element;
+      if (it.second["name"].isString())
+        element.name = it.second["name"].asString();
+
+      if (it.second.hasKey("properties")) {
+        for (auto prop : it.second["properties"].children()) {
+          ELEMENT_PROPERTY_T property;
+          if (ParseProperty(prop.first, prop.second, &property))
+            element.properties.push_back(property);
+        }
+      }
+
+      pbnjson::JValue devices = it.second["device"];
+      for (gint32 j = 0; devices.isArray() && j < devices.arraySize(); ++j)
+        element.devices.push_back(devices[j].isString() ? devices[j].asString() : "");
+
+      if (gst_is_initialized())
+        ResolveElement(it.first.asString(), &element);
+
+      config->elements[std::make_pair(i, it.first.asString())] = std::move(element);
+    }
+  }
+  config->resolved = gst_is_initialized();
+
+  GMP_DEBUG_PRINT("%s loaded, %zu elements", path, config->elements.size());
+  return config;
+}
+
+const ELEMENT_CONFIG_T * ElementFactory::FindElement(const ELEMENT_FACTORY_CONFIG_T &config,
+  const std::string &pipelineType, const std::string &elementTypeName) {
+  auto it = config.elements.find(
+      std::make_pair(GetPipelineType(pipelineType), elementTypeName));
+  if (it == config.elements.end()) {
     GMP_DEBUG_PRINT("elementTypeName : %s is not exist",
       elementTypeName.c_str());
+    return nullptr;
   }
-
-  return elementName;
+  return &it->second;
 }
 
-GstElement * ElementFactory::GetGstElement(const std::string &pipelineType, const std::string &name) {
-  GstElement * element = NULL;
-  std::string elementName = GetPreferredElementName(pipelineType, name);
-  element = gst_element_factory_make(elementName.c_str(), name.c_str());
+GstElement * ElementFactory::Create(const std::string &pipelineType,
+  const std::string &elementTypeName, uint32_t displayPath) {
+  std::shared_ptr<const ELEMENT_FACTORY_CONFIG_T> config = GetConfig();
+  const ELEMENT_CONFIG_T *elementConfig =
+      FindElement(*config, pipelineType, elementTypeName);
+  if (!elementConfig)
+    return NULL;
+
+  GMP_DEBUG_PRINT("%s : %s", elementTypeName.c_str(), elementConfig->name.c_str());
+  if (!elementConfig->factory)
+    return NULL;
+
+  GstElement * element = gst_element_factory_create(elementConfig->factory.get(),
+                                                    elementTypeName.c_str());
+  if (!element)
+    return NULL;
+
+  for (const auto &property : elementConfig->resolved)
+    property.Apply(element);
+
+  if (displayPath < elementConfig->devices.size()
+    && !elementConfig->devices[displayPath].empty()) {
+    GMP_DEBUG_PRINT("Select device %d - name : %s",
+      displayPath, elementConfig->devices[displayPath].c_str());
+    ELEMENT_PROPERTY_T device;
+    device.name = "device";
+    device.type = ELEMENT_PROPERTY_STRING;
+    device.strValue = elementConfig->devices[displayPath];
+    SetProperty(element, device);
+  }
 
   return element;
 }
 
+gint32 ElementFactory::GetUseAudioProperty() {
+  return GetConfig()->useAudio;
+}
+
+// Total bytes all players may queue, in MB. 0 when not configured.
+guint64 ElementFactory::GetMemoryBudget() {
+  return GetConfig()->memoryBudgetMb;
+}
+
+bool ElementFactory::GetAllowNoWindow() {
+  return GetConfig()->allowNoWindow;
+}
+
+guint32 ElementFactory::GetPipelinePoolSize() {
+  return GetConfig()->pipelinePoolSize;
+}
+
+bool ElementFactory::GetPipelinePoolReady() {
+  return GetConfig()->pipelinePoolReady;
+}
+
+guint32 ElementFactory::GetDiscoveryCacheSize() {
+  return GetConfig()->discoveryCacheSize;
+}
+
+bool ElementFactory::GetSkipDiscovery() {
+  return GetConfig()->skipDiscovery;
+}
+
+guint32 ElementFactory::GetNotifyMinIntervalMs() {
+  return GetConfig()->notifyMinIntervalMs;
+}
+
+std::string ElementFactory::GetPlatform(void)
+{
+  std::shared_ptr<const ELEMENT_FACTORY_CONFIG_T> config = GetConfig();
+  GMP_DEBUG_PRINT("Platform : %s", config->platform.c_str());
+  return config->platform;
+}
+
 gint32 ElementFactory::GetPipelineType(const std::string &pipelineType)
 {
   if (pipelineType == "playbin") {
@@ -142,53 +313,163 @@ gint32 ElementFactory::GetPipelineType(const std::string &pipelineType)
   }
 }
 
-void ElementFactory::SetProperty(GstElement * element,
-  const pbnjson::JValue &prop, const pbnjson::JValue &value) {
-  const pbnjson::JValue &objProp = prop;
-  const pbnjson::JValue &objValue = value;
-  if (objProp.isString()) {
-    std::string strProp = objProp.asString();
-    if (objValue.isNumber()) {
-      gint32 num = objValue.asNumber<gint32>();
-      GMP_DEBUG_PRINT("property - %s : %d", strProp.c_str(), num);
-      g_object_set(G_OBJECT(element), strProp.c_str(), num, nullptr);
-    } else if (objValue.isString()) {
-      GMP_DEBUG_PRINT("property - %s : %s", strProp.c_str(), objValue.asString().c_str());
-      g_object_set(G_OBJECT(element), strProp.c_str(), objValue.asString().c_str(),  nullptr);
-    } else if (objValue.isBoolean()) {
-      GMP_DEBUG_PRINT("property - %s : %s", strProp.c_str(), objValue.asBool() ? "true" : "false");
-      g_object_set(G_OBJECT(element), strProp.c_str(), objValue.asBool(),  nullptr);
-    } else {
-      GMP_DEBUG_PRINT("Please check the value type of %s",
-        strProp.c_str());
-    }
-  } else {
+bool ElementFactory::ParseProperty(const pbnjson::JValue &prop,
+  const pbnjson::JValue &value, ELEMENT_PROPERTY_T *property) {
+  if (!prop.isString()) {
     GMP_DEBUG_PRINT("A property name should be string. \
       Please check the json file.");
+    return false;
+  }
+
+  property->name = prop.asString();
+  property->intValue = 0;
+  property->boolValue = FALSE;
+  if (value.isNumber()) {
+    property->type = ELEMENT_PROPERTY_INT;
+    property->intValue = value.asNumber<gint32>();
+  } else if (value.isString()) {
+    property->type = ELEMENT_PROPERTY_STRING;
+    property->strValue = value.asString();
+  } else if (value.isBoolean()) {
+    property->type = ELEMENT_PROPERTY_BOOL;
+    property->boolValue = value.asBool();
+  } else {
+    GMP_DEBUG_PRINT("Please check the value type of %s",
+      property->name.c_str());
+    return false;
   }
+  return true;
 }
 
-void ElementFactory::SetAllproperties(const std::string &pipelineType,
-  const std::string &elementTypeName, GstElement * element) {
-  pbnjson::JValue root = pbnjson::JDomParser::fromFile(gst_element_json_path);
-  if (!root.isObject()) {
-    GMP_DEBUG_PRINT("Gst element file parsing error");
+/* Looks up the factory and the GParamSpec of every configured property, so
+ * that a typo in gst_elements.conf shows up when it is loaded. Properties
+ * which don't exist or don't convert are dropped. */
+void ElementFactory::ResolveElement(const std::string &elementTypeName,
+  ELEMENT_CONFIG_T *element) {
+  if (element->name.empty())
+    return;
+
+  GstElementFactory *factory = gst_element_factory_find(element->name.c_str());
+  if (!factory) {
+    GMP_INFO_PRINT("%s : no element named %s, please check the json file",
+      elementTypeName.c_str(), element->name.c_str());
     return;
   }
 
-  pbnjson::JValue elements = root["gst_elements"];
-  int i = GetPipelineType(pipelineType);
-  if (elements[i].hasKey(elementTypeName)
-    && elements[i][elementTypeName].hasKey("name")) {
-    if (elements[i][elementTypeName].hasKey("properties")) {
-      for(auto it : elements[i][elementTypeName]["properties"].children()) {
-        SetProperty(element, it.first, it.second);
-      }
+  GstPluginFeature *loaded = gst_plugin_feature_load(GST_PLUGIN_FEATURE(factory));
+  gst_object_unref(factory);
+  if (!loaded) {
+    GMP_INFO_PRINT("%s : failed to load %s",
+      elementTypeName.c_str(), element->name.c_str());
+    return;
+  }
+  element->factory.reset(GST_ELEMENT_FACTORY(loaded), gst_object_unref);
+
+  GType type = gst_element_factory_get_element_type(element->factory.get());
+  GObjectClass *klass = G_OBJECT_CLASS(g_type_class_ref(type));
+  for (const auto &property : element->properties) {
+    GParamSpec *pspec = g_object_class_find_property(klass, property.name.c_str());
+    if (!pspec || !(pspec->flags & G_PARAM_WRITABLE)) {
+      GMP_INFO_PRINT("%s : %s has no writable property %s",
+        elementTypeName.c_str(), element->name.c_str(), property.name.c_str());
+      continue;
     }
+
+    GValue value = G_VALUE_INIT;
+    if (!ConvertProperty(property, pspec, &value)) {
+      GMP_INFO_PRINT("%s : invalid value for %s.%s",
+        elementTypeName.c_str(), element->name.c_str(), property.name.c_str());
+      continue;
+    }
+    element->resolved.emplace_back(property.name, &value);
+    g_value_unset(&value);
+  }
+  g_type_class_unref(klass);
+}
+
+bool ElementFactory::ConvertProperty(const ELEMENT_PROPERTY_T &property,
+  GParamSpec *pspec, GValue *value) {
+  GValue src = G_VALUE_INIT;
+  switch (property.type) {
+    case ELEMENT_PROPERTY_INT:
+      g_value_init(&src, G_TYPE_INT);
+      g_value_set_int(&src, property.intValue);
+      break;
+    case ELEMENT_PROPERTY_STRING:
+      g_value_init(&src, G_TYPE_STRING);
+      g_value_set_string(&src, property.strValue.c_str());
+      break;
+    case ELEMENT_PROPERTY_BOOL:
+      g_value_init(&src, G_TYPE_BOOLEAN);
+      g_value_set_boolean(&src, property.boolValue);
+      break;
+    default:
+      return false;
+  }
+
+  g_value_init(value, G_PARAM_SPEC_VALUE_TYPE(pspec));
+  gboolean ret = FALSE;
+  if (property.type == ELEMENT_PROPERTY_STRING
+    && !g_value_type_compatible(G_TYPE_STRING, G_VALUE_TYPE(value))) {
+    // enum nicks, flags, caps and the like
+    ret = gst_value_deserialize(value, property.strValue.c_str());
+  } else if (property.type == ELEMENT_PROPERTY_INT && G_VALUE_HOLDS_ENUM(value)) {
+    g_value_set_enum(value, property.intValue);
+    ret = TRUE;
+  } else if (property.type == ELEMENT_PROPERTY_INT && G_VALUE_HOLDS_FLAGS(value)) {
+    g_value_set_flags(value, property.intValue);
+    ret = TRUE;
   } else {
-    GMP_DEBUG_PRINT("elementTypeName : %s is not exist",
-      elementTypeName.c_str());
+    ret = g_value_transform(&src, value);
+  }
+  g_value_unset(&src);
+
+  // g_param_value_validate() returns TRUE when it had to fix the value
+  if (!ret || g_param_value_validate(pspec, value)) {
+    g_value_unset(value);
+    return false;
+  }
+  return true;
+}
+
+void ElementFactory::SetProperty(GstElement * element,
+  const ELEMENT_PROPERTY_T &property) {
+  const gchar *name = property.name.c_str();
+  switch (property.type) {
+    case ELEMENT_PROPERTY_INT:
+      GMP_DEBUG_PRINT("property - %s : %d", name, property.intValue);
+      g_object_set(G_OBJECT(element), name, property.intValue, nullptr);
+      break;
+    case ELEMENT_PROPERTY_STRING:
+      GMP_DEBUG_PRINT("property - %s : %s", name, property.strValue.c_str());
+      g_object_set(G_OBJECT(element), name, property.strValue.c_str(), nullptr);
+      break;
+    case ELEMENT_PROPERTY_BOOL:
+      GMP_DEBUG_PRINT("property - %s : %s", name, property.boolValue ? "true" : "false");
+      g_object_set(G_OBJECT(element), name, property.boolValue, nullptr);
+      break;
+    default:
+      break;
+  }
+}
+
+void ElementFactory::SetAllproperties(const std::string &pipelineType,
+  const std::string &elementTypeName, GstElement * element) {
+  std::shared_ptr<const ELEMENT_FACTORY_CONFIG_T> config = GetConfig();
+  const ELEMENT_CONFIG_T *elementConfig =
+      FindElement(*config, pipelineType, elementTypeName);
+  if (!elementConfig || !element)
+    return;
+
+  if (elementConfig->factory && G_OBJECT_TYPE(element) ==
+      gst_element_factory_get_element_type(elementConfig->factory.get())) {
+    for (const auto &property : elementConfig->resolved)
+      property.Apply(element);
+    return;
   }
+
+  for (const auto &property : elementConfig->properties)
+    SetProperty(element, property);
 }
 
 }  // namespace pf
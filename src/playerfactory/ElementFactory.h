@@ -18,14 +18,77 @@
 #ifndef SRC_PLAYERFACTORY_ELEMENTCREATOR_H_
 #define SRC_PLAYERFACTORY_ELEMENTCREATOR_H_
 
+#include <ctime>
+#include <map>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 #include <gst/gst.h>
 #include <pbnjson.hpp>
 
 #include "PlayerTypes.h"
 
 namespace gmp { namespace pf {
+
+typedef enum {
+  ELEMENT_PROPERTY_INT = 0,
+  ELEMENT_PROPERTY_STRING,
+  ELEMENT_PROPERTY_BOOL,
+} ELEMENT_PROPERTY_TYPE_T;
+
+typedef struct {
+  std::string name;
+  ELEMENT_PROPERTY_TYPE_T type;
+  gint32 intValue;
+  std::string strValue;
+  gboolean boolValue;
+} ELEMENT_PROPERTY_T;
+
+// A configured property converted once to the type of its GParamSpec.
+class ElementProperty {
+ public:
+  ElementProperty(const std::string &name, const GValue *value);
+  ElementProperty(const ElementProperty &other);
+  ~ElementProperty();
+  ElementProperty & operator=(const ElementProperty &other);
+
+  void Apply(GstElement *element) const;
+  const std::string & GetName() const { return name_; }
+
+ private:
+  std::string name_;
+  GValue value_ = G_VALUE_INIT;
+};
+
+typedef struct {
+  std::string name;                         // gst factory name, may be empty
+  std::vector<ELEMENT_PROPERTY_T> properties;
+  std::vector<std::string> devices;         // indexed by display path
+  std::shared_ptr<GstElementFactory> factory;  // null if it didn't resolve
+  std::vector<ElementProperty> resolved;    // properties valid for factory
+} ELEMENT_CONFIG_T;
+
+// gst_elements.conf as parsed once, never modified after it is published.
+typedef struct {
+  std::string path;
+  time_t mtime;
+  off_t size;
+  bool valid;
+  bool resolved;       // factories and properties looked up, needs gst_init
+  std::string platform;
+  gint32 useAudio;
+  guint64 memoryBudgetMb;
+  bool allowNoWindow;
+  guint32 pipelinePoolSize;
+  bool pipelinePoolReady;
+  guint32 discoveryCacheSize;
+  bool skipDiscovery;
+  guint32 notifyMinIntervalMs;
+  std::map<std::pair<gint32, std::string>, ELEMENT_CONFIG_T> elements;
+} ELEMENT_FACTORY_CONFIG_T;
+
 class ElementFactory {
  public:
   ElementFactory() {
@@ -37,18 +100,40 @@ class ElementFactory {
     const std::string &elementTypeName, uint32_t displayPath = DEFAULT_DISPLAY);
   static std::string GetPlatform(void);
   static gint32 GetUseAudioProperty(void);
+  static guint64 GetMemoryBudget(void);
+  static bool GetAllowNoWindow(void);
+  static guint32 GetPipelinePoolSize(void);
+  static bool GetPipelinePoolReady(void);
+  static guint32 GetDiscoveryCacheSize(void);
+  static bool GetSkipDiscovery(void);
+  static guint32 GetNotifyMinIntervalMs(void);
 
   static void SetAllproperties(const std::string &pipelineType,
     const std::string &elementTypeName, GstElement * element);
+
+  // The config is read on first use. Reload() re-reads it unconditionally,
+  // ReloadIfChanged() only when the file or its path changed since.
+  static bool Reload(void);
+  static bool ReloadIfChanged(void);
+
  private:
-  static std::string GetPreferredElementName(const std::string &pipelineType,
-    const std::string & elementTypeName);
-  static GstElement * GetGstElement(const std::string &pipelineType,
-    const std::string &name);
+  static std::shared_ptr<const ELEMENT_FACTORY_CONFIG_T> GetConfig(void);
+  static std::shared_ptr<const ELEMENT_FACTORY_CONFIG_T> ParseConfig(const char *path);
+  static const ELEMENT_CONFIG_T * FindElement(const ELEMENT_FACTORY_CONFIG_T &config,
+    const std::string &pipelineType, const std::string &elementTypeName);
   static gint32 GetPipelineType(const std::string &pipelineType);
-  static void SetProperty(GstElement * element,
-    const pbnjson::JValue &prop, const pbnjson::JValue &value);
+  static bool ParseProperty(const pbnjson::JValue &prop,
+    const pbnjson::JValue &value, ELEMENT_PROPERTY_T *property);
+  static void ResolveElement(const std::string &elementTypeName,
+    ELEMENT_CONFIG_T *element);
+  static bool ConvertProperty(const ELEMENT_PROPERTY_T &property,
+    GParamSpec *pspec, GValue *value);
+  static void SetProperty(GstElement * element, const ELEMENT_PROPERTY_T &property);
+  static const char * GetConfigPath(void);
   static const char gst_element_json_path[];
+
+  static std::mutex configLock_;
+  static std::shared_ptr<const ELEMENT_FACTORY_CONFIG_T> config_;
 };
 
 }  // namespace pf
@@ -18,7 +18,6 @@
 #include <glib.h>
 #include <glib-unix.h>
 #include <gst/gst.h>
-#include <pbnjson.hpp>
 #include <regex>
 
 #include "PlayerFactory.h"
@@ -34,19 +33,11 @@ PlayerFactory::PlayerFactory() {}
 
 PlayerFactory::~PlayerFactory() {}
 
-std::shared_ptr<gmp::player::Player> PlayerFactory::CreatePlayer(const std::string &str, GMP_PLAYER_TYPE &playerType) {
+std::shared_ptr<gmp::player::Player> PlayerFactory::CreatePlayer(const base::load_param_t &param, GMP_PLAYER_TYPE &playerType) {
   std::shared_ptr<gmp::player::Player> player;
 
-  pbnjson::JDomParser jdparser;
-  if (!jdparser.parse(str, pbnjson::JSchema::AllSchema())) {
-    GMP_DEBUG_PRINT("ERROR JDomParser.parse. msg: %s ", str.c_str());
-    return nullptr;
-  }
-  pbnjson::JValue parsed = jdparser.getDom();
-
-  if (parsed.hasKey("uri")) {
-    std::string uri_ = parsed["uri"].asString();
-    GMP_DEBUG_PRINT("uri = %s", uri_.c_str());
+  if (!param.uri.empty()) {
+    GMP_DEBUG_PRINT("uri = %s", param.uri.c_str());
 
     playerType = GMP_PLAYER_TYPE_URI;
     GMP_DEBUG_PRINT("Create UriPlainPlayer");
@@ -15,6 +15,7 @@
 
 #include <string>
 #include <memory>
+#include "base/types.h"
 #include "player/PlayerTypes.h"
 
 namespace gmp { namespace player { class Player; }}
@@ -26,7 +27,7 @@ class PlayerFactory {
   PlayerFactory();
   ~PlayerFactory();
 
-  static std::shared_ptr<gmp::player::Player> CreatePlayer(const std::string &str, GMP_PLAYER_TYPE &playerType);
+  static std::shared_ptr<gmp::player::Player> CreatePlayer(const base::load_param_t &param, GMP_PLAYER_TYPE &playerType);
   static std::shared_ptr<gmp::player::Player> CreatePlayer(const MEDIA_LOAD_DATA_T*);
 };
 
@@ -0,0 +1,136 @@
+// Copyright (c) 2020 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <vector>
+
+#include "coalescer.h"
+#include "log/log.h"
+
+namespace gmp { namespace service {
+
+NotificationCoalescer::NotificationCoalescer(SendFunction send,
+                                             guint32 min_interval_ms)
+  : send_(std::move(send))
+  , min_interval_(static_cast<gint64>(min_interval_ms) * 1000) {
+  GMP_INFO_PRINT("notify min interval %u ms", min_interval_ms);
+}
+
+NotificationCoalescer::~NotificationCoalescer() {
+  if (timer_id_)
+    g_source_remove(timer_id_);
+}
+
+void NotificationCoalescer::Post(const char *key, const std::string &payload) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (!key || min_interval_ <= 0) {
+    FlushLocked(true);
+    send_(payload);
+    // After a transition the same value has to be delivered again.
+    if (!key) {
+      for (auto &entry : slots_)
+        entry.second.last.clear();
+    }
+    return;
+  }
+
+  Slot &slot = slots_[key];
+  if (!slot.sequence && payload == slot.last)
+    return;
+
+  slot.pending = payload;
+  if (!slot.sequence)
+    slot.sequence = next_sequence_++;
+
+  // Nothing older may overtake it, so it only goes out now when alone.
+  bool others_pending = std::any_of(slots_.begin(), slots_.end(),
+      [&slot](const std::pair<const std::string, Slot> &entry) {
+        return entry.second.sequence && entry.second.sequence < slot.sequence;
+      });
+  if (!others_pending &&
+      g_get_monotonic_time() - slot.last_sent >= min_interval_) {
+    SendLocked(&slot);
+    return;
+  }
+  ScheduleLocked();
+}
+
+void NotificationCoalescer::Flush() {
+  std::lock_guard<std::mutex> lock(lock_);
+  FlushLocked(true);
+}
+
+gboolean NotificationCoalescer::FlushTimeout(gpointer user_data) {
+  NotificationCoalescer *coalescer =
+      static_cast<NotificationCoalescer *>(user_data);
+  std::lock_guard<std::mutex> lock(coalescer->lock_);
+  coalescer->timer_id_ = 0;
+  coalescer->FlushLocked(false);
+  coalescer->ScheduleLocked();
+  return G_SOURCE_REMOVE;
+}
+
+// A pending payload that went back to the last one delivered is dropped.
+void NotificationCoalescer::SendLocked(Slot *slot) {
+  slot->sequence = 0;
+  if (slot->pending == slot->last)
+    return;
+  send_(slot->pending);
+  slot->last.swap(slot->pending);
+  slot->last_sent = g_get_monotonic_time();
+}
+
+// Sends pending notifications oldest first. Unless all of them must go,
+// stops at the first one whose interval has not elapsed yet.
+void NotificationCoalescer::FlushLocked(bool all) {
+  std::vector<Slot *> pending;
+  for (auto &entry : slots_) {
+    if (entry.second.sequence)
+      pending.push_back(&entry.second);
+  }
+  std::sort(pending.begin(), pending.end(), [](const Slot *a, const Slot *b) {
+    return a->sequence < b->sequence;
+  });
+
+  gint64 now = g_get_monotonic_time();
+  for (Slot *slot : pending) {
+    if (!all && now - slot->last_sent < min_interval_)
+      break;
+    SendLocked(slot);
+  }
+}
+
+// The oldest pending notification holds the others back, wait for it.
+void NotificationCoalescer::ScheduleLocked() {
+  if (timer_id_)
+    return;
+
+  const Slot *oldest = nullptr;
+  for (const auto &entry : slots_) {
+    const Slot &slot = entry.second;
+    if (slot.sequence && (!oldest || slot.sequence < oldest->sequence))
+      oldest = &slot;
+  }
+  if (!oldest)
+    return;
+
+  gint64 wait = oldest->last_sent + min_interval_ - g_get_monotonic_time();
+  timer_id_ = g_timeout_add(std::max<gint64>(1, (wait + 999) / 1000),
+                            FlushTimeout, this);
+}
+
+}  // namespace service
+}  // namespace gmp
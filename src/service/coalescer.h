@@ -0,0 +1,72 @@
+// Copyright (c) 2020 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef SRC_SERVICE_COALESCER_H_
+#define SRC_SERVICE_COALESCER_H_
+
+#include <glib.h>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace gmp { namespace service {
+
+/* Rate limiter between Service::Notify and uMediaServer.
+ *
+ * Notifications posted with a key (currentTime, bufferRange, ...) are
+ * delivered at most once per min_interval_ms per key; a repeat within the
+ * interval replaces the pending one, and a payload identical to the last
+ * one delivered for its key is dropped. Notifications posted without a key
+ * are transitions: everything pending is flushed first, in the order it
+ * was posted, then the transition is sent, so clients never see a state
+ * after the transition that ended it. A transition also forgets the last
+ * payloads, the first one of each key after it is always delivered. */
+class NotificationCoalescer {
+ public:
+  using SendFunction = std::function<void(const std::string &)>;
+
+  NotificationCoalescer(SendFunction send, guint32 min_interval_ms);
+  ~NotificationCoalescer();
+
+  void Post(const char *key, const std::string &payload);
+  void Flush();
+
+ private:
+  struct Slot {
+    std::string pending;
+    std::string last;
+    gint64 last_sent = 0;
+    guint64 sequence = 0;  // 0 when nothing is pending
+  };
+
+  static gboolean FlushTimeout(gpointer user_data);
+  void SendLocked(Slot *slot);
+  void FlushLocked(bool all);
+  void ScheduleLocked();
+
+  std::mutex lock_;
+  SendFunction send_;
+  gint64 min_interval_;  // usec
+  std::map<std::string, Slot> slots_;
+  guint64 next_sequence_ = 1;
+  guint timer_id_ = 0;
+};
+
+}  // namespace service
+}  // namespace gmp
+
+#endif  // SRC_SERVICE_COALESCER_H_
@@ -16,6 +16,7 @@
 
 #include <stdlib.h>
 #include <unistd.h>
+#include <algorithm>
 #include <string>
 #include <UMSConnector.h>
 #include "log/log.h"
@@ -23,13 +24,52 @@
 #include "base/message.h"
 #include "parser/parser.h"
 #include "parser/composer.h"
+#include "parser/writer.h"
 #include "player/Player.h"
 #include "mediaresource/requestor.h"
 #include "service/service.h"
+#include "service/coalescer.h"
+#include "playerfactory/ElementFactory.h"
 #include "playerfactory/PlayerFactory.h"
+#include "player/MemoryBudget.h"
 #include <memory>
 
 namespace gmp { namespace service {
+
+namespace {
+
+// Only the latest notification of these is worth sending, per key.
+const char *CoalesceKey(const gint notification) {
+  switch (notification) {
+    case NOTIFY_CURRENT_TIME: return "currentTime";
+    case NOTIFY_BUFFER_RANGE: return "bufferRange";
+    case NOTIFY_VIDEO_INFO: return "videoInfo";
+    case NOTIFY_AUDIO_INFO: return "audioInfo";
+    case NOTIFY_PLAYING:
+    case NOTIFY_PAUSED: return "playState";
+    default: return nullptr;
+  }
+}
+
+// Sent as they come, after everything coalesced before them.
+bool IsTransition(const gint notification) {
+  switch (notification) {
+    case NOTIFY_LOAD_COMPLETED:
+    case NOTIFY_UNLOAD_COMPLETED:
+    case NOTIFY_SOURCE_INFO:
+    case NOTIFY_END_OF_STREAM:
+    case NOTIFY_SEEK_DONE:
+    case NOTIFY_ERROR:
+    case NOTIFY_BUFFERING_START:
+    case NOTIFY_BUFFERING_END:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
 Service *Service::instance_ = nullptr;
 
 Service::Service(const std::string& service_name) {
@@ -80,83 +120,124 @@ Service* Service::GetInstance(const std::string& service_name) {
 
 Service::~Service() {}
 
-void Service::Notify(const gint notification, const gint64 numValue, const gchar *strValue, void *payload) {
+// Notifications with a fixed shape, sent the most often, skip the pbnjson DOM.
+bool Service::WriteNotification(gmp::parser::Writer *writer, const Session *session, const gint notification, void *payload) {
+  const char *state = nullptr;
+  switch (notification) {
+    case NOTIFY_CURRENT_TIME:
+      writer->put("currentTime", *static_cast<gmp::base::time_t *>(payload),
+                  session->media_id);
+      return true;
+    case NOTIFY_BUFFER_RANGE:
+      writer->put("bufferRange", *static_cast<base::buffer_range_t *>(payload),
+                  session->media_id);
+      return true;
+    case NOTIFY_LOAD_COMPLETED: state = "loadCompleted"; break;
+    case NOTIFY_UNLOAD_COMPLETED: state = "unloadCompleted"; break;
+    case NOTIFY_END_OF_STREAM: state = "endOfStream"; break;
+    case NOTIFY_SEEK_DONE: state = "seekDone"; break;
+    case NOTIFY_PLAYING: state = "playing"; break;
+    case NOTIFY_PAUSED: state = "paused"; break;
+    case NOTIFY_BUFFERING_START: state = "bufferingStart"; break;
+    case NOTIFY_BUFFERING_END: state = "bufferingEnd"; break;
+    default:
+      return false;
+  }
+
+  gmp::base::media_info_t mediaInfo = { session->media_id };
+  writer->put(state, mediaInfo);
+  return true;
+}
+
+void Service::Notify(Session *session, const gint notification, const gint64 numValue, const gchar *strValue, void *payload) {
+  // Player internal callbacks (activity, resources, feed levels) have
+  // nothing for uMediaServer.
+  if (!CoalesceKey(notification) && !IsTransition(notification))
+    return;
+
+  // players notify from more than one thread, each gets its own buffer
+  static thread_local gmp::parser::Writer writer;
+  if (WriteNotification(&writer, session, notification, payload)) {
+    GMP_DEBUG_PRINT(" payload_str = %s", writer.result().c_str());
+    session->coalescer->Post(CoalesceKey(notification), writer.result());
+    return;
+  }
+
   gmp::parser::Composer composer;
-  gmp::base::media_info_t mediaInfo = { media_id_ };
   switch (notification) {
-    case NOTIFY_CURRENT_TIME: {
-      gmp::base::time_t current_position  = *static_cast<gmp::base::time_t *>(payload);
-      composer.put("currentTime", current_position);
-      break;
-    }
     case NOTIFY_SOURCE_INFO: {
       base::source_info_t info  = *static_cast<base::source_info_t *>(payload);
       composer.put("sourceInfo", info);
+      composer.put("mediaId", session->media_id);
       break;
     }
     case NOTIFY_VIDEO_INFO: {
       base::video_info_t info = *static_cast<base::video_info_t*>(payload);
       composer.put("videoInfo", info);
+      composer.put("mediaId", session->media_id);
       GMP_INFO_PRINT("videoInfo: width %d, height %d", info.width, info.height);
       break;
     }
     case NOTIFY_AUDIO_INFO: {
       base::audio_info_t info = *static_cast<base::audio_info_t*>(payload);
       composer.put("audioInfo", info);
+      composer.put("mediaId", session->media_id);
       break;
     }
     case NOTIFY_ERROR: {
       base::error_t error = *static_cast<base::error_t *>(payload);
-      error.mediaId = media_id_;
+      error.mediaId = session->media_id;
       composer.put("error", error);
 
       break;
     }
-    case NOTIFY_BUFFER_RANGE: {
-      base::buffer_range_t range = *static_cast<base::buffer_range_t *>(payload);
-      composer.put("bufferRange", range);
-      break;
-    }
-    case NOTIFY_LOAD_COMPLETED: {
-      composer.put("loadCompleted", mediaInfo);
-      break;
-    }
-    case NOTIFY_UNLOAD_COMPLETED: {
-      composer.put("unloadCompleted", mediaInfo);
-      break;
-    }
-    case NOTIFY_END_OF_STREAM: {
-      composer.put("endOfStream", mediaInfo);
-      break;
-    }
-    case NOTIFY_SEEK_DONE: {
-      composer.put("seekDone", mediaInfo);
-      break;
-    }
-    case NOTIFY_PLAYING: {
-      composer.put("playing", mediaInfo);
-      break;
-    }
-    case NOTIFY_PAUSED: {
-      composer.put("paused", mediaInfo);
-      break;
-    }
-    case NOTIFY_BUFFERING_START: {
-      composer.put("bufferingStart", mediaInfo);
-      break;
-    }
-    case NOTIFY_BUFFERING_END: {
-      composer.put("bufferingEnd", mediaInfo);
-      break;
-    }
     default: {
       GMP_DEBUG_PRINT("This notification(%d) can't be handled here!", notification);
-      break;
+      return;
     }
   }
   std::string payload_str = composer.result();
   GMP_DEBUG_PRINT(" payload_str = %s", payload_str.c_str());
-  umc_->sendChangeNotificationJsonString(payload_str);
+  session->coalescer->Post(CoalesceKey(notification), payload_str);
+}
+
+// Plain subscribers get the notifications of every session, subscribers
+// that asked for one session get its notifications as well. Every payload
+// names its session, by a "mediaId" key or inside the state object.
+void Service::SendNotification(const Session *session, const std::string &payload) {
+  bool keyed;
+  {
+    std::lock_guard<std::mutex> lock(subscribers_lock_);
+    keyed = subscribed_ids_.count(session->media_id) > 0;
+  }
+  umc_->sendChangeNotificationJsonString(payload);
+  if (keyed)
+    umc_->sendChangeNotificationJsonString(payload, session->media_id);
+}
+
+// Messages name their session by {"mediaId": id} or a bare id string.
+std::string Service::GetMediaId(const std::string &message) {
+  try {
+    gmp::parser::Parser parser(message.c_str());
+    try {
+      return parser.get<std::string>("mediaId");
+    } catch (const gmp::parser::parser_error &) {
+      return parser.get<std::string>();
+    }
+  } catch (const gmp::parser::parser_error &) {
+    return std::string();
+  }
+}
+
+// Messages that name no session go to the one loaded last.
+Service::Session *Service::FindSession(const std::string &message) {
+  std::string media_id = GetMediaId(message);
+  auto it = sessions_.find(media_id.empty() ? default_media_id_ : media_id);
+  if (it == sessions_.end()) {
+    GMP_DEBUG_PRINT("no session for mediaId '%s'", media_id.c_str());
+    return nullptr;
+  }
+  return it->second.get();
 }
 
 bool Service::Wait() {
@@ -172,34 +253,57 @@ bool Service::LoadEvent(UMSConnectorHandle *handle, UMSConnectorMessage *message
   std::string msg = instance_->umc_->getMessageText(message);
   GMP_DEBUG_PRINT("%s", msg.c_str());
 
-  pbnjson::JDomParser parser;
-  if (!parser.parse(msg, pbnjson::JSchema::AllSchema())) {
-      GMP_DEBUG_PRINT("ERROR JDomParser.parse. msg=%s", msg.c_str());
-      return false;
+  // The only parse of the payload, players get the typed fields.
+  base::load_param_t param;
+  try {
+    param = gmp::parser::Parser(msg.c_str()).get_load_param();
+  } catch (const gmp::parser::parser_error &e) {
+    GMP_DEBUG_PRINT("ERROR %s. msg=%s", e.what(), msg.c_str());
+    return false;
   }
-  pbnjson::JValue parsed = parser.getDom();
-  if (!parsed.hasKey("id") && parsed["id"].isString()) {
+  if (param.mediaId.empty()) {
     GMP_DEBUG_PRINT("id is invalid");
     return false;
   }
-  instance_->media_id_ = parsed["id"].asString();
-  instance_->app_id_ = parsed["options"]["option"]["appId"].asString();
 
-  instance_->media_player_client_ =
-    std::make_unique<gmp::player::MediaPlayerClient>(instance_->app_id_, instance_->media_id_);
+  // A reload of a loaded id ends the old session first.
+  auto it = instance_->sessions_.find(param.mediaId);
+  if (it != instance_->sessions_.end()) {
+    GMP_INFO_PRINT("session %s loaded again", param.mediaId.c_str());
+    instance_->UnloadSession(it->second.get());
+  }
 
-  instance_->media_player_client_->RegisterCallback(
-    std::bind(&Service::Notify, instance_,
+  std::unique_ptr<Session> &slot = instance_->sessions_[param.mediaId];
+  slot = std::make_unique<Session>();
+  Session *session = slot.get();
+  session->media_id = param.mediaId;
+  session->app_id = param.appId;
+  session->load_sequence = ++instance_->next_load_sequence_;
+  session->update_intervals = instance_->update_intervals_;
+  session->coalescer = std::make_unique<NotificationCoalescer>(
+    [session](const std::string &payload) {
+      instance_->SendNotification(session, payload);
+    }, gmp::pf::ElementFactory::GetNotifyMinIntervalMs());
+  instance_->default_media_id_ = session->media_id;
+  GMP_INFO_PRINT("session %s loaded, %zu in this process",
+                 session->media_id.c_str(), instance_->sessions_.size());
+
+  session->client =
+    std::make_unique<gmp::player::MediaPlayerClient>(session->app_id, session->media_id);
+
+  session->client->RegisterCallback(
+    std::bind(&Service::Notify, instance_, session,
       std::placeholders::_1, std::placeholders::_2,
       std::placeholders::_3, std::placeholders::_4));
+  instance_->ApplyUpdateInterval(session);
 
   bool ret;
-  ret = instance_->media_player_client_->Load(msg);
+  ret = session->client->Load(param);
   if (!ret) {
     base::error_t error;
     error.errorCode = MEDIA_MSG_ERR_LOAD;
     error.errorText = "Load Failed";
-    instance_->Notify(NOTIFY_ERROR, 0, nullptr, static_cast<void*>(&error));
+    instance_->Notify(session, NOTIFY_ERROR, 0, nullptr, static_cast<void*>(&error));
   }
   return ret;
 }
@@ -209,17 +313,45 @@ bool Service::AttachEvent(UMSConnectorHandle *handle, UMSConnectorMessage *messa
 }
 
 bool Service::UnloadEvent(UMSConnectorHandle *handle, UMSConnectorMessage *message, void *ctxt) {
+  Session *session = instance_->FindSession(instance_->umc_->getMessageText(message));
+  if (!session)
+    return false;
+  return instance_->UnloadSession(session);
+}
+
+// Unloads the player and drops the session. Messages that name no session
+// go to the latest loaded of the remaining ones.
+bool Service::UnloadSession(Session *session) {
   bool ret;
-  ret = instance_->media_player_client_->Unload();
+  ret = session->client->Unload();
   if (!ret) {
     base::error_t error;
     error.errorCode = MEDIA_MSG_ERR_LOAD;
     error.errorText = "Unload Failed";
-    instance_->Notify(NOTIFY_ERROR, 0, nullptr, static_cast<void*>(&error));
+    Notify(session, NOTIFY_ERROR, 0, nullptr, static_cast<void*>(&error));
   }
 
-  instance_->media_player_client_.reset();
-  instance_->Notify(NOTIFY_UNLOAD_COMPLETED, 0, nullptr, nullptr);
+  session->client.reset();
+  Notify(session, NOTIFY_UNLOAD_COMPLETED, 0, nullptr, nullptr);
+
+  std::string media_id = session->media_id;
+  sessions_.erase(media_id);
+  {
+    std::lock_guard<std::mutex> lock(subscribers_lock_);
+    subscribed_ids_.erase(media_id);
+  }
+  if (default_media_id_ == media_id) {
+    default_media_id_.clear();
+    guint64 latest = 0;
+    for (const auto &it : sessions_) {
+      if (it.second->load_sequence > latest) {
+        latest = it.second->load_sequence;
+        default_media_id_ = it.first;
+      }
+    }
+  }
+  GMP_INFO_PRINT("session %s unloaded, %zu in this process",
+                 media_id.c_str(), sessions_.size());
 
   return ret;
 }
@@ -227,25 +359,58 @@ bool Service::UnloadEvent(UMSConnectorHandle *handle, UMSConnectorMessage *messa
 // media operations
 bool Service::PlayEvent(UMSConnectorHandle *handle, UMSConnectorMessage *message, void *ctxt) {
   GMP_DEBUG_PRINT("PlayEvent");
-  return instance_->media_player_client_->Play();
+  Session *session = instance_->FindSession(instance_->umc_->getMessageText(message));
+  return session && session->client->Play();
 }
 
 bool Service::PauseEvent(UMSConnectorHandle *handle, UMSConnectorMessage *message, void *ctxt) {
   GMP_DEBUG_PRINT("PauseEvent");
-  return instance_->media_player_client_->Pause();
+  Session *session = instance_->FindSession(instance_->umc_->getMessageText(message));
+  return session && session->client->Pause();
 }
 
+// Either {"mediaId": id, "position": ms} or a bare position.
 bool Service::SeekEvent(UMSConnectorHandle *handle, UMSConnectorMessage *message, void *ctxt) {
   GMP_DEBUG_PRINT("SeekEvent");
-  int64_t position = std::stoll(instance_->umc_->getMessageText(message));
-  return instance_->media_player_client_->Seek(position);
+  std::string msg = instance_->umc_->getMessageText(message);
+  Session *session = instance_->FindSession(msg);
+  if (!session)
+    return false;
+
+  int64_t position = 0;
+  try {
+    gmp::parser::Parser parser(msg.c_str());
+    try {
+      position = parser.get<int64_t>("position");
+    } catch (const gmp::parser::parser_error &) {
+      position = parser.get<int64_t>();
+    }
+  } catch (const gmp::parser::parser_error &e) {
+    GMP_DEBUG_PRINT("invalid seek message: %s", e.what());
+    return false;
+  }
+  return session->client->Seek(position);
 }
 
+// A subscription naming a mediaId may come before that session is loaded.
 bool Service::StateChangeEvent(UMSConnectorHandle *handle, UMSConnectorMessage *message, void *ctxt) {
-  return instance_->umc_->addSubscriber(handle, message);
+  std::string media_id = GetMediaId(instance_->umc_->getMessageText(message));
+  if (media_id.empty())
+    return instance_->umc_->addSubscriber(handle, message);
+
+  {
+    std::lock_guard<std::mutex> lock(instance_->subscribers_lock_);
+    instance_->subscribed_ids_.insert(media_id);
+  }
+  return instance_->umc_->addSubscriber(handle, message, media_id);
 }
 
 bool Service::UnsubscribeEvent(UMSConnectorHandle *handle, UMSConnectorMessage *message, void *ctxt) {
+  std::string media_id = GetMediaId(instance_->umc_->getMessageText(message));
+  if (!media_id.empty()) {
+    std::lock_guard<std::mutex> lock(instance_->subscribers_lock_);
+    instance_->subscribed_ids_.erase(media_id);
+  }
   return true;
 }
 
@@ -255,20 +420,88 @@ bool Service::SetUriEvent(UMSConnectorHandle *handle, UMSConnectorMessage *messa
 
 bool Service::SetPlayRateEvent(UMSConnectorHandle *handle, UMSConnectorMessage *message, void *ctxt) {
   GMP_DEBUG_PRINT("SetPlayRateEvent");
-  gmp::parser::Parser parser(instance_->umc_->getMessageText(message));
-  return instance_->media_player_client_->SetPlaybackRate(parser.get<double>("playRate"));
+  std::string msg = instance_->umc_->getMessageText(message);
+  Session *session = instance_->FindSession(msg);
+  if (!session)
+    return false;
+  gmp::parser::Parser parser(msg.c_str());
+  return session->client->SetPlaybackRate(parser.get<double>("playRate"));
 }
 
 bool Service::SelectTrackEvent(UMSConnectorHandle *handle, UMSConnectorMessage *message, void *ctxt) {
-  return true;
+  GMP_DEBUG_PRINT("SelectTrackEvent");
+  std::string msg = instance_->umc_->getMessageText(message);
+  Session *session = instance_->FindSession(msg);
+  if (!session)
+    return false;
+
+  try {
+    gmp::parser::Parser parser(msg.c_str());
+    return session->client->SelectTrack(
+        parser.get<std::string>("type"), parser.get<int32_t>("index"));
+  } catch (const gmp::parser::parser_error &e) {
+    GMP_DEBUG_PRINT("invalid selectTrack message: %s", e.what());
+    return false;
+  }
 }
 
+// Either {"interval": ms} or a bare number, for the default client.
 bool Service::SetUpdateIntervalEvent(UMSConnectorHandle *handle, UMSConnectorMessage *message, void *ctxt) {
-  return true;
+  GMP_DEBUG_PRINT("SetUpdateIntervalEvent");
+  std::string msg = instance_->umc_->getMessageText(message);
+  int32_t interval = 0;
+  try {
+    gmp::parser::Parser parser(msg.c_str());
+    try {
+      interval = parser.get<int32_t>("interval");
+    } catch (const gmp::parser::parser_error &) {
+      interval = parser.get<int32_t>();
+    }
+  } catch (const gmp::parser::parser_error &e) {
+    GMP_DEBUG_PRINT("invalid setUpdateInterval message: %s", e.what());
+    return false;
+  }
+  return instance_->SetUpdateInterval(instance_->FindSession(msg), std::string(), interval);
 }
 
+// {"key": client, "value": ms}, a value <= 0 drops the client's request.
 bool Service::SetUpdateIntervalKVEvent(UMSConnectorHandle *handle, UMSConnectorMessage *message, void *ctxt) {
-  return true;
+  GMP_DEBUG_PRINT("SetUpdateIntervalKVEvent");
+  try {
+    std::string msg = instance_->umc_->getMessageText(message);
+    gmp::parser::Parser parser(msg.c_str());
+    return instance_->SetUpdateInterval(instance_->FindSession(msg),
+                                        parser.get<std::string>("key"),
+                                        parser.get<int32_t>("value"));
+  } catch (const gmp::parser::parser_error &e) {
+    GMP_DEBUG_PRINT("invalid setUpdateIntervalKV message: %s", e.what());
+    return false;
+  }
+}
+
+// The player reports as often as its most demanding client asked for.
+// Requests made before any load apply to every session loaded later.
+bool Service::SetUpdateInterval(Session *session, const std::string &key, int32_t interval) {
+  GMP_DEBUG_PRINT("update interval [%s] %d ms", key.c_str(), interval);
+  std::map<std::string, int32_t> &intervals =
+      session ? session->update_intervals : update_intervals_;
+  if (interval > 0)
+    intervals[key] = interval;
+  else
+    intervals.erase(key);
+  return session ? ApplyUpdateInterval(session) : true;
+}
+
+bool Service::ApplyUpdateInterval(Session *session) {
+  int32_t effective = 0;
+  for (const auto &it : session->update_intervals)
+    effective = effective ? std::min(effective, it.second) : it.second;
+
+  GMP_DEBUG_PRINT("effective update interval of %s %d ms",
+                  session->media_id.c_str(), effective);
+  if (!session->client)
+    return true;
+  return session->client->SetUpdateInterval(effective);
 }
 
 bool Service::ChangeResolutionEvent(UMSConnectorHandle *handle, UMSConnectorMessage *message, void *ctxt) {
@@ -285,8 +518,12 @@ bool Service::SetPropertyEvent(UMSConnectorHandle *handle, UMSConnectorMessage *
 
 bool Service::SetVolumeEvent(UMSConnectorHandle *handle, UMSConnectorMessage *message, void *ctxt) {
   GMP_DEBUG_PRINT("SetVolumeEvent");
-  gmp::parser::Parser parser(instance_->umc_->getMessageText(message));
-  return instance_->media_player_client_->SetVolume(parser.get<int>("volume"));
+  std::string msg = instance_->umc_->getMessageText(message);
+  Session *session = instance_->FindSession(msg);
+  if (!session)
+    return false;
+  gmp::parser::Parser parser(msg.c_str());
+  return session->client->SetVolume(parser.get<int>("volume"));
 }
 
 bool Service::SetPlaneEvent(UMSConnectorHandle *handle, UMSConnectorMessage *message, void *ctxt) {
@@ -299,6 +536,14 @@ bool Service::GetPipelineStateEvent(UMSConnectorHandle *handle, UMSConnectorMess
 }
 
 bool Service::LogPipelineStateEvent(UMSConnectorHandle *handle, UMSConnectorMessage *message, void *ctxt) {
+  for (const auto &it : instance_->sessions_) {
+    const Session *session = it.second.get();
+    GMP_INFO_PRINT("session %s%s: queued %" G_GUINT64_FORMAT " bytes",
+                   session->media_id.c_str(),
+                   session->media_id == instance_->default_media_id_ ? " (default)" : "",
+                   session->client ? session->client->GetMemoryUsage() : 0);
+  }
+  gmp::player::MemoryBudget::GetInstance().Dump();
   return true;
 }
 
@@ -312,6 +557,8 @@ bool Service::SetPipelineDebugStateEvent(UMSConnectorHandle *handle, UMSConnecto
 
 // exit
 bool Service::ExitEvent(UMSConnectorHandle *handle, UMSConnectorMessage *message, void *ctxt) {
+  for (const auto &it : instance_->sessions_)
+    it.second->coalescer->Flush();
   return instance_->umc_->stop();
 }
 }  // namespace service
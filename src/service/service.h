@@ -17,7 +17,10 @@
 #ifndef SRC_SERVICE_SERVICE_H_
 #define SRC_SERVICE_SERVICE_H_
 
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 
 #include <player/PlayerTypes.h>
@@ -28,13 +31,16 @@ class UMSConnector;
 class UMSConnectorHandle;
 class UMSConnectorMessage;
 
+namespace gmp { namespace parser { class Writer; }}
+
 namespace gmp { namespace service {
+class NotificationCoalescer;
+
 class Service {
  public:
   static Service* GetInstance(const std::string& service_name);
   ~Service();
 
-  void Notify(const gint notification, const gint64 numValue, const gchar *strValue, void *payload = nullptr);
   bool Wait();
   bool Stop();
 
@@ -70,17 +76,40 @@ class Service {
   static bool ExitEvent(UMSConnectorHandle *handle, UMSConnectorMessage *message, void *ctxt);
 
  private:
+  // One loaded media. A process hosts any number of them, UMS messages
+  // pick theirs by "mediaId".
+  struct Session {
+    std::string media_id;  // connection_id
+    std::string app_id;
+    std::unique_ptr<NotificationCoalescer> coalescer;  // outlives client
+    std::unique_ptr<gmp::player::MediaPlayerClient> client;
+    std::map<std::string, int32_t> update_intervals;  // ms per client key
+    guint64 load_sequence = 0;  // higher for later loads
+  };
+
   explicit Service(const std::string& service_name);
   Service(const Service& s) = delete;
   void operator=(const Service& s) = delete;
 
+  void Notify(Session *session, const gint notification, const gint64 numValue, const gchar *strValue, void *payload = nullptr);
+  bool WriteNotification(gmp::parser::Writer *writer, const Session *session, const gint notification, void *payload);
+  void SendNotification(const Session *session, const std::string &payload);
+  static std::string GetMediaId(const std::string &message);
+  Session *FindSession(const std::string &message);
+  bool UnloadSession(Session *session);
+  bool SetUpdateInterval(Session *session, const std::string &key, int32_t interval);
+  bool ApplyUpdateInterval(Session *session);
+
   static Service *instance_;
 
   std::unique_ptr<UMSConnector> umc_;
-  std::unique_ptr<gmp::player::MediaPlayerClient> media_player_client_;
+  std::map<std::string, std::unique_ptr<Session>> sessions_;  // by media id
+  std::string default_media_id_;  // session of messages that name none
+  guint64 next_load_sequence_ = 0;
+  std::map<std::string, int32_t> update_intervals_;  // requested before any load
 
-  std::string media_id_;  // connection_id
-  std::string app_id_;
+  std::mutex subscribers_lock_;
+  std::set<std::string> subscribed_ids_;  // sessions with their own subscribers
 };
 
 }  // namespace service
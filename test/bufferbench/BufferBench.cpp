@@ -0,0 +1,512 @@
+// Copyright (c) 2020 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+/* Headless BufferPlayer benchmark.
+ *
+ * Feeds a local file into BufferPlayer as fast as the player accepts it and
+ * reports feed latency percentiles, decode throughput and peak RSS.
+ * The player is configured through the gst_elements.conf next to this file,
+ * which renders to fakesink, so no window or display server is needed.
+ *
+ *   bufferplayer_bench <file>                demux a container file
+ *   bufferplayer_bench -r video <dump>       raw ES dump (GST_DUMP_FILENAME)
+ *   bufferplayer_bench -r audio <dump>
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <getopt.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/app/gstappsink.h>
+#include <mediaplayerclient/MediaPlayerClient.h>
+
+#define RAW_CHUNK_SIZE (64 * 1024)
+#define FULL_RETRY_US 1000
+#define EOS_TIMEOUT_SEC 300
+#define PREROLL_TIMEOUT_SEC 10
+
+namespace {
+
+struct FeedResult {
+  std::vector<gint64> latencies;  // usec per accepted Feed() call
+  guint64 units = 0;
+  guint64 bytes = 0;
+  guint64 fullRetries = 0;
+  bool failed = false;
+};
+
+struct BenchContext {
+  std::unique_ptr<gmp::player::MediaPlayerClient> client;
+  std::mutex lock;
+  std::condition_variable cond;
+  bool finished = false;
+  bool error = false;
+  guint64 decodedFrames = 0;
+  guint64 renderedAudio = 0;
+};
+
+void Notify(BenchContext *ctx, const gint type, const gint64 numValue,
+            const gchar *strValue, void *payload) {
+  switch (type) {
+    case NOTIFY_END_OF_STREAM: {
+      std::lock_guard<std::mutex> lock(ctx->lock);
+      ctx->finished = true;
+      ctx->cond.notify_all();
+      break;
+    }
+    case NOTIFY_ERROR: {
+      std::lock_guard<std::mutex> lock(ctx->lock);
+      std::cout << "player error: " << numValue << std::endl;
+      ctx->error = true;
+      ctx->finished = true;
+      ctx->cond.notify_all();
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+GstPadProbeReturn SinkProbe(GstPad *pad, GstPadProbeInfo *info, gpointer userData) {
+  guint64 *counter = static_cast<guint64 *>(userData);
+  __atomic_add_fetch(counter, 1, __ATOMIC_RELAXED);
+  return GST_PAD_PROBE_OK;
+}
+
+bool AddSinkProbe(GstElement *pipeline, const gchar *name, guint64 *counter) {
+  GstElement *sink = gst_bin_get_by_name(GST_BIN(pipeline), name);
+  if (!sink)
+    return false;
+
+  GstPad *pad = gst_element_get_static_pad(sink, "sink");
+  if (pad) {
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, SinkProbe, counter, NULL);
+    gst_object_unref(pad);
+  }
+  gst_object_unref(sink);
+  return pad != NULL;
+}
+
+/* Retries while the player reports MEDIA_BUFFER_FULL, only the accepted
+ * call is timed so the numbers reflect the cost of the feed path itself. */
+bool FeedUnit(gmp::player::MediaPlayerClient *client, const guint8 *data,
+              guint32 size, guint64 pts, MEDIA_DATA_CHANNEL_T ch,
+              FeedResult *result) {
+  while (true) {
+    gint64 start = g_get_monotonic_time();
+    MEDIA_STATUS_T ret = client->Feed(data, size, pts, ch);
+    gint64 end = g_get_monotonic_time();
+
+    if (ret == MEDIA_OK) {
+      result->latencies.push_back(end - start);
+      result->units++;
+      result->bytes += size;
+      return true;
+    }
+    if (ret != MEDIA_BUFFER_FULL) {
+      std::cout << "Feed failed, ret = " << ret << std::endl;
+      result->failed = true;
+      return false;
+    }
+    result->fullRetries++;
+    g_usleep(FULL_RETRY_US);
+  }
+}
+
+void FeedRawFile(gmp::player::MediaPlayerClient *client, const std::string &path,
+                 MEDIA_DATA_CHANNEL_T ch, guint32 chunkSize, FeedResult *result) {
+  FILE *fp = fopen(path.c_str(), "rb");
+  if (!fp) {
+    std::cout << "cannot open " << path << std::endl;
+    result->failed = true;
+    return;
+  }
+
+  std::vector<guint8> chunk(chunkSize);
+  size_t readSize = 0;
+  while ((readSize = fread(chunk.data(), 1, chunk.size(), fp)) > 0) {
+    if (!FeedUnit(client, chunk.data(), readSize, GST_CLOCK_TIME_NONE, ch, result))
+      break;
+  }
+  fclose(fp);
+}
+
+void FeedAppSink(gmp::player::MediaPlayerClient *client, GstElement *appSink,
+                 MEDIA_DATA_CHANNEL_T ch, FeedResult *result) {
+  GstSample *sample = nullptr;
+  while ((sample = gst_app_sink_pull_sample(GST_APP_SINK(appSink))) != nullptr) {
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    GstMapInfo mapInfo;
+    if (buffer && gst_buffer_map(buffer, &mapInfo, GST_MAP_READ)) {
+      bool ok = FeedUnit(client, mapInfo.data, mapInfo.size,
+                         GST_BUFFER_PTS(buffer), ch, result);
+      gst_buffer_unmap(buffer, &mapInfo);
+      if (!ok) {
+        gst_sample_unref(sample);
+        break;
+      }
+    }
+    gst_sample_unref(sample);
+  }
+}
+
+GMP_VIDEO_CODEC GetVideoCodec(const GstStructure *s) {
+  const gchar *name = gst_structure_get_name(s);
+  if (!g_strcmp0(name, "video/x-h264"))
+    return GMP_VIDEO_CODEC_H264;
+  if (!g_strcmp0(name, "video/x-h265"))
+    return GMP_VIDEO_CODEC_H265;
+  if (!g_strcmp0(name, "video/x-vp8"))
+    return GMP_VIDEO_CODEC_VP8;
+  if (!g_strcmp0(name, "video/x-vp9"))
+    return GMP_VIDEO_CODEC_VP9;
+  return GMP_VIDEO_CODEC_NONE;
+}
+
+GMP_AUDIO_CODEC GetAudioCodec(const GstStructure *s) {
+  const gchar *name = gst_structure_get_name(s);
+  if (!g_strcmp0(name, "audio/mpeg")) {
+    // BufferPlayer has no mp3 parser, only take AAC
+    gint version = 0;
+    gst_structure_get_int(s, "mpegversion", &version);
+    return version == 1 ? GMP_AUDIO_CODEC_NONE : GMP_AUDIO_CODEC_AAC;
+  }
+  if (!g_strcmp0(name, "audio/x-ac3"))
+    return GMP_AUDIO_CODEC_AC3;
+  if (!g_strcmp0(name, "audio/x-eac3"))
+    return GMP_AUDIO_CODEC_EAC3;
+  return GMP_AUDIO_CODEC_NONE;
+}
+
+/* filesrc ! parsebin, the first video and audio pads go to appsinks which
+ * the feeder threads pull from. Streams the player can't take are dropped. */
+class Demuxer {
+ public:
+  ~Demuxer() {
+    if (videoCaps_)
+      gst_caps_unref(videoCaps_);
+    if (audioCaps_)
+      gst_caps_unref(audioCaps_);
+    if (pipeline_) {
+      gst_element_set_state(pipeline_, GST_STATE_NULL);
+      gst_object_unref(pipeline_);
+    }
+  }
+
+  bool Open(const std::string &path) {
+    pipeline_ = gst_pipeline_new("bench-demux");
+    GstElement *src = gst_element_factory_make("filesrc", NULL);
+    GstElement *parseBin = gst_element_factory_make("parsebin", NULL);
+    videoSink_ = gst_element_factory_make("appsink", "bench-video");
+    audioSink_ = gst_element_factory_make("appsink", "bench-audio");
+    if (!pipeline_ || !src || !parseBin || !videoSink_ || !audioSink_)
+      return false;
+
+    g_object_set(G_OBJECT(src), "location", path.c_str(), NULL);
+    for (GstElement *sink : { videoSink_, audioSink_ })
+      g_object_set(G_OBJECT(sink), "sync", FALSE, "max-buffers", 64, NULL);
+
+    gst_bin_add_many(GST_BIN(pipeline_), src, parseBin, videoSink_, audioSink_, NULL);
+    if (!gst_element_link(src, parseBin))
+      return false;
+    g_signal_connect(parseBin, "pad-added", G_CALLBACK(PadAddedCB), this);
+    g_signal_connect(parseBin, "no-more-pads", G_CALLBACK(NoMorePadsCB), this);
+
+    // Don't let an appsink without a stream hold the preroll.
+    for (GstElement *sink : { videoSink_, audioSink_ })
+      g_object_set(G_OBJECT(sink), "async", FALSE, NULL);
+
+    if (gst_element_set_state(pipeline_, GST_STATE_PAUSED) == GST_STATE_CHANGE_FAILURE)
+      return false;
+
+    std::unique_lock<std::mutex> lock(lock_);
+    if (!cond_.wait_for(lock, std::chrono::seconds(PREROLL_TIMEOUT_SEC),
+                        [this] { return noMorePads_; })) {
+      std::cout << "demuxer didn't expose its streams" << std::endl;
+      return false;
+    }
+
+    // Unlinked appsinks would never get EOS and block their feeder.
+    if (videoCodec_ == GMP_VIDEO_CODEC_NONE)
+      RemoveSink(&videoSink_);
+    if (audioCodec_ == GMP_AUDIO_CODEC_NONE)
+      RemoveSink(&audioSink_);
+
+    return videoSink_ || audioSink_;
+  }
+
+  void Start() {
+    gst_element_set_state(pipeline_, GST_STATE_PLAYING);
+  }
+
+  GstElement *videoSink_ = nullptr;
+  GstElement *audioSink_ = nullptr;
+  GMP_VIDEO_CODEC videoCodec_ = GMP_VIDEO_CODEC_NONE;
+  GMP_AUDIO_CODEC audioCodec_ = GMP_AUDIO_CODEC_NONE;
+  GstCaps *videoCaps_ = nullptr;
+  GstCaps *audioCaps_ = nullptr;
+
+ private:
+  static void PadAddedCB(GstElement *element, GstPad *pad, gpointer userData) {
+    Demuxer *demuxer = static_cast<Demuxer *>(userData);
+    GstCaps *caps = gst_pad_query_caps(pad, NULL);
+    const GstStructure *s = gst_caps_get_structure(caps, 0);
+
+    GstElement *sink = nullptr;
+    GMP_VIDEO_CODEC videoCodec = GetVideoCodec(s);
+    GMP_AUDIO_CODEC audioCodec = GetAudioCodec(s);
+    if (videoCodec != GMP_VIDEO_CODEC_NONE &&
+        demuxer->videoCodec_ == GMP_VIDEO_CODEC_NONE) {
+      demuxer->videoCodec_ = videoCodec;
+      demuxer->videoCaps_ = gst_caps_ref(caps);
+      sink = demuxer->videoSink_;
+    } else if (audioCodec != GMP_AUDIO_CODEC_NONE &&
+               demuxer->audioCodec_ == GMP_AUDIO_CODEC_NONE) {
+      demuxer->audioCodec_ = audioCodec;
+      demuxer->audioCaps_ = gst_caps_ref(caps);
+      sink = demuxer->audioSink_;
+    }
+
+    if (sink) {
+      GstPad *sinkPad = gst_element_get_static_pad(sink, "sink");
+      if (gst_pad_link(pad, sinkPad) != GST_PAD_LINK_OK)
+        std::cout << "link fail for " << gst_structure_get_name(s) << std::endl;
+      gst_object_unref(sinkPad);
+    } else {
+      std::cout << "skip stream " << gst_structure_get_name(s) << std::endl;
+    }
+    gst_caps_unref(caps);
+  }
+
+  static void NoMorePadsCB(GstElement *element, gpointer userData) {
+    Demuxer *demuxer = static_cast<Demuxer *>(userData);
+    std::lock_guard<std::mutex> lock(demuxer->lock_);
+    demuxer->noMorePads_ = true;
+    demuxer->cond_.notify_all();
+  }
+
+  void RemoveSink(GstElement **sink) {
+    gst_element_set_state(*sink, GST_STATE_NULL);
+    gst_bin_remove(GST_BIN(pipeline_), *sink);
+    *sink = nullptr;
+  }
+
+  GstElement *pipeline_ = nullptr;
+  std::mutex lock_;
+  std::condition_variable cond_;
+  bool noMorePads_ = false;
+};
+
+void SetAppSrcCaps(GstElement *pipeline, const gchar *name, GstCaps *caps) {
+  GstElement *src = gst_bin_get_by_name(GST_BIN(pipeline), name);
+  if (src) {
+    gst_app_src_set_caps(GST_APP_SRC(src), caps);
+    gst_object_unref(src);
+  }
+}
+
+gint64 Percentile(const std::vector<gint64> &sorted, double p) {
+  if (sorted.empty())
+    return 0;
+  size_t idx = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+void PrintReport(const FeedResult &video, const FeedResult &audio,
+                 const BenchContext &ctx, gint64 feedUsec, gint64 totalUsec) {
+  std::vector<gint64> latencies(video.latencies);
+  latencies.insert(latencies.end(), audio.latencies.begin(), audio.latencies.end());
+  std::sort(latencies.begin(), latencies.end());
+
+  double feedSec = feedUsec / static_cast<double>(G_USEC_PER_SEC);
+  double totalSec = totalUsec / static_cast<double>(G_USEC_PER_SEC);
+  guint64 units = video.units + audio.units;
+  guint64 bytes = video.bytes + audio.bytes;
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  printf("feed: %" G_GUINT64_FORMAT " AUs, %" G_GUINT64_FORMAT " bytes in %.3f sec"
+         " (%.1f AUs/sec, %.2f MB/sec), %" G_GUINT64_FORMAT " full retries\n",
+         units, bytes, feedSec, feedSec > 0 ? units / feedSec : 0.0,
+         feedSec > 0 ? bytes / feedSec / (1024 * 1024) : 0.0,
+         video.fullRetries + audio.fullRetries);
+  printf("feed latency (usec): p50 %" G_GINT64_FORMAT " p90 %" G_GINT64_FORMAT
+         " p99 %" G_GINT64_FORMAT " p99.9 %" G_GINT64_FORMAT " max %" G_GINT64_FORMAT "\n",
+         Percentile(latencies, 0.5), Percentile(latencies, 0.9),
+         Percentile(latencies, 0.99), Percentile(latencies, 0.999),
+         latencies.empty() ? 0 : latencies.back());
+  printf("decode: %" G_GUINT64_FORMAT " video frames, %" G_GUINT64_FORMAT
+         " audio buffers in %.3f sec (%.1f frames/sec)\n",
+         ctx.decodedFrames, ctx.renderedAudio, totalSec,
+         totalSec > 0 ? ctx.decodedFrames / totalSec : 0.0);
+  printf("peak rss: %ld KB\n", usage.ru_maxrss);
+}
+
+void PrintUsage(const char *name) {
+  std::cout << "Usage: " << name << " [options] <file>" << std::endl
+            << "  -r video|audio   <file> is a raw ES dump instead of a container" << std::endl
+            << "  -v h264|h265     video codec of a raw dump (default h264)" << std::endl
+            << "  -c bytes         chunk size for raw dumps (default 65536)" << std::endl
+            << "  -a               use the async feed mode" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  std::string rawType;
+  GMP_VIDEO_CODEC rawVideoCodec = GMP_VIDEO_CODEC_H264;
+  guint32 chunkSize = RAW_CHUNK_SIZE;
+  gboolean asyncFeed = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "r:v:c:ah")) != -1) {
+    switch (opt) {
+      case 'r': rawType = optarg; break;
+      case 'v':
+        rawVideoCodec = !g_strcmp0(optarg, "h265") ? GMP_VIDEO_CODEC_H265
+                                                   : GMP_VIDEO_CODEC_H264;
+        break;
+      case 'c': chunkSize = std::max(1, atoi(optarg)); break;
+      case 'a': asyncFeed = true; break;
+      default:
+        PrintUsage(argv[0]);
+        return 1;
+    }
+  }
+  if (optind >= argc || (!rawType.empty() && rawType != "video" && rawType != "audio")) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+  std::string path(argv[optind]);
+
+  // Render to fakesink unless the caller points at another element table.
+  g_setenv("GMP_GST_ELEMENTS_CONF", BENCH_CONF_DIR "/gst_elements.conf", FALSE);
+  g_setenv("GMP_GST_DEBUG_CONF", BENCH_CONF_DIR "/gst_debug.conf", FALSE);
+
+  gst_init(&argc, &argv);
+  GMainLoop *loop = g_main_loop_new(NULL, FALSE);
+
+  MEDIA_LOAD_DATA_T loadData;
+  loadData.maxWidth = 1920;
+  loadData.maxHeight = 1080;
+  loadData.maxFrameRate = 60;
+  loadData.asyncFeed = asyncFeed;
+
+  Demuxer demuxer;
+  if (rawType.empty()) {
+    if (!demuxer.Open(path)) {
+      std::cout << "cannot demux " << path << std::endl;
+      return 1;
+    }
+    loadData.videoCodec = demuxer.videoCodec_;
+    loadData.audioCodec = demuxer.audioCodec_;
+  } else if (rawType == "video") {
+    loadData.videoCodec = rawVideoCodec;
+  } else {
+    loadData.audioCodec = GMP_AUDIO_CODEC_AAC;
+  }
+
+  BenchContext ctx;
+  ctx.client = std::make_unique<gmp::player::MediaPlayerClient>();
+  ctx.client->RegisterCallback(
+      std::bind(&Notify, &ctx, std::placeholders::_1, std::placeholders::_2,
+                std::placeholders::_3, std::placeholders::_4));
+
+  if (!ctx.client->Load(&loadData) || !ctx.client->Play()) {
+    std::cout << "player load failed" << std::endl;
+    return 1;
+  }
+
+  GstElement *playerPipeline = ctx.client->GetPipeline();
+  if (loadData.videoCodec != GMP_VIDEO_CODEC_NONE &&
+      !AddSinkProbe(playerPipeline, "video-sink", &ctx.decodedFrames))
+    std::cout << "no video-sink to count frames on" << std::endl;
+  if (loadData.audioCodec != GMP_AUDIO_CODEC_NONE)
+    AddSinkProbe(playerPipeline, "audio-sink", &ctx.renderedAudio);
+
+  FeedResult videoResult, audioResult;
+  gint64 startTime = 0;
+  gint64 feedEndTime = 0;
+
+  std::thread feeder([&]() {
+    startTime = g_get_monotonic_time();
+    if (rawType == "video") {
+      FeedRawFile(ctx.client.get(), path, MEDIA_DATA_CH_A, chunkSize, &videoResult);
+    } else if (rawType == "audio") {
+      FeedRawFile(ctx.client.get(), path, MEDIA_DATA_CH_B, chunkSize, &audioResult);
+    } else {
+      if (demuxer.videoCaps_)
+        SetAppSrcCaps(playerPipeline, "video-app-es", demuxer.videoCaps_);
+      if (demuxer.audioCaps_)
+        SetAppSrcCaps(playerPipeline, "audio-app-es", demuxer.audioCaps_);
+      demuxer.Start();
+
+      std::thread audioFeeder;
+      if (demuxer.audioSink_)
+        audioFeeder = std::thread(FeedAppSink, ctx.client.get(), demuxer.audioSink_,
+                                  MEDIA_DATA_CH_B, &audioResult);
+      if (demuxer.videoSink_)
+        FeedAppSink(ctx.client.get(), demuxer.videoSink_, MEDIA_DATA_CH_A, &videoResult);
+      if (audioFeeder.joinable())
+        audioFeeder.join();
+    }
+    feedEndTime = g_get_monotonic_time();
+
+    if (!videoResult.failed && !audioResult.failed) {
+      ctx.client->PushEndOfStream();
+      std::unique_lock<std::mutex> lock(ctx.lock);
+      if (!ctx.cond.wait_for(lock, std::chrono::seconds(EOS_TIMEOUT_SEC),
+                             [&ctx] { return ctx.finished; })) {
+        std::cout << "timed out waiting for EOS" << std::endl;
+        ctx.error = true;
+      }
+    } else {
+      ctx.error = true;
+    }
+
+    PrintReport(videoResult, audioResult, ctx, feedEndTime - startTime,
+                g_get_monotonic_time() - startTime);
+    // From the loop itself, a quit before g_main_loop_run() would be lost.
+    g_idle_add([](gpointer data) -> gboolean {
+      g_main_loop_quit(static_cast<GMainLoop *>(data));
+      return G_SOURCE_REMOVE;
+    }, loop);
+  });
+
+  g_main_loop_run(loop);
+  feeder.join();
+
+  ctx.client->Unload();
+  ctx.client.reset();
+  g_main_loop_unref(loop);
+
+  return ctx.error ? 1 : 0;
+}
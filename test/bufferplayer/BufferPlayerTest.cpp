@@ -42,6 +42,8 @@ static bool doSeek(gmp::test::StreamSource& source,
                    const std::string& param = std::string());
 static bool doUnload(gmp::test::StreamSource& source,
                      const std::string& param = std::string());
+static bool doThroughput(gmp::test::StreamSource& source,
+                         const std::string& param = std::string());
 
 std::string window_id;
 std::string test_uri("http://10.178.84.247/mp4/sintel.mp4");
@@ -51,16 +53,18 @@ enum class BufferPlayerAPI : int {
   PLAY,
   PAUSE,
   SEEK,
-  UNLOAD
+  UNLOAD,
+  THROUGHPUT
 };
 
-#define MAX_MENU_COUNT 5
+#define MAX_MENU_COUNT 6
 std::string menu_table[MAX_MENU_COUNT] = {
   "load",
   "play",
   "pause",
   "seek",
-  "unload"
+  "unload",
+  "throughput"
 };
 
 std::map<std::string, functionPtr> input_table = {
@@ -69,6 +73,7 @@ std::map<std::string, functionPtr> input_table = {
   { "3", &doPause },
   { "4", &doSeek },
   { "5", &doUnload },
+  { "6", &doThroughput },
 };
 
 static bool doLoad(gmp::test::StreamSource& source, const std::string& param)
@@ -99,6 +104,13 @@ static bool doUnload(gmp::test::StreamSource& source, const std::string& param)
   return source.Unload();
 }
 
+static bool doThroughput(gmp::test::StreamSource& source, const std::string& param)
+{
+  UNUSED(param);
+  source.PrintThroughput();
+  return true;
+}
+
 static void printMenu(void)
 {
   std::cout << std::string("*** Buffer Player Test Command ***") << std::endl;
@@ -159,6 +171,11 @@ static bool processCommand(const std::string& cmd, gmp::test::StreamSource& sour
       ret = iter->second(source, std::string());
       break;
     }
+    case BufferPlayerAPI::THROUGHPUT: {
+      std::cout << std::string("Throughput command!") << std::endl;
+      ret = iter->second(source, std::string());
+      break;
+    }
     default:
       std::cout << std::string("Wrong command!") << std::endl;
       break;
@@ -313,107 +313,118 @@ void StreamSource::MultiQueuePadAddedCB(GstElement* element, GstPad* pad, gpoint
 GstFlowReturn StreamSource::VideoAppSinkSampleAddedCB(GstElement *element, gpointer userData)
 {
   StreamSource *streamSrc = reinterpret_cast<StreamSource *>(userData);
-  gchar* elementName = gst_element_get_name(element);
-  MEDIA_STATUS_T ret;
-  GstElement* pipeline = streamSrc->media_player_client_->GetPipeline();
+  // can't use static variable after unload. so added firstVideoSample variable.
+  return streamSrc->FeedSample(element, "video-app-es", MEDIA_DATA_CH_A,
+                               streamSrc->firstVideoSample);
+}
+
+GstFlowReturn StreamSource::AudioAppSinkSampleAddedCB(GstElement *element, gpointer userData)
+{
+  StreamSource *streamSrc = reinterpret_cast<StreamSource *>(userData);
+  // can't use static variable after unload. so added firstAudioSample variable.
+  return streamSrc->FeedSample(element, "audio-app-es", MEDIA_DATA_CH_B,
+                               streamSrc->firstAudioSample);
+}
+
+/* The appsink buffer is mapped and handed to the player as is, it is
+ * unmapped and released once the player's pipeline is done with it. */
+GstFlowReturn StreamSource::FeedSample(GstElement *element, const gchar *srcName,
+                                       MEDIA_DATA_CHANNEL_T esData, bool &firstSample)
+{
+  GstElement* pipeline = media_player_client_->GetPipeline();
   if (!pipeline)
     return GST_FLOW_ERROR;
 
-  GstElement* source = gst_bin_get_by_name(GST_BIN(pipeline), "video-app-es");
+  GstElement* source = gst_bin_get_by_name(GST_BIN(pipeline), srcName);
+  if (!source)
+    return GST_FLOW_ERROR;
 
   /* get the sample from appsink */
   GstSample* sample = gst_app_sink_pull_sample(GST_APP_SINK(element));
-  GstBuffer* buffer = gst_sample_get_buffer(sample);
-
-  /* make a copy */
-  GstBuffer* appBuffer = gst_buffer_copy(buffer);
-  GST_BUFFER_PTS(appBuffer) = GST_CLOCK_TIME_NONE;
-
-  /* we don't need the appsink sample anymore */
-  gst_sample_unref(sample);
+  if (!sample) {
+    gst_object_unref(source);
+    return GST_FLOW_ERROR;
+  }
 
-  // can't use static variable after unload. so added firstVideoSample variable.
-  if (!streamSrc->firstVideoSample) {
-    GstPad* srcPad = gst_element_get_static_pad(source, "src");
+  if (!firstSample) {
     GstPad* sinkPad = gst_element_get_static_pad(element, "sink");
     GstCaps* caps = gst_pad_get_current_caps(sinkPad);
     gst_app_src_set_caps(GST_APP_SRC(source), caps);
-    streamSrc->firstVideoSample = true;
+    firstSample = true;
 //    print_caps(caps, "\t");
-    gst_object_unref(srcPad);
+    if (caps)
+      gst_caps_unref(caps);
     gst_object_unref(sinkPad);
   }
-
-  /* get buffer and size from Gstbuffer */
-  GstMapInfo mapInfo;
-  gst_buffer_map(appBuffer, &mapInfo, GST_MAP_READ);
-
-  guint8* bufferData = reinterpret_cast<guint8 *>(mapInfo.data);
-  guint32 bufferSize = mapInfo.size; // gst_buffer_get_size(AppBuffer)
-
-  ret = streamSrc->media_player_client_->Feed(bufferData, bufferSize, GST_CLOCK_TIME_NONE, MEDIA_DATA_CH_A);
-
-  gst_buffer_unmap(appBuffer, &mapInfo);
-  g_free(elementName);
   gst_object_unref(source);
 
-  if (ret == MEDIA_OK)
-    return GST_FLOW_OK;
-  else
-    return GST_FLOW_ERROR;
-}
+  /* keep the buffer alive past the sample, it is released by the player */
+  MappedBuffer* mapped = g_new0(MappedBuffer, 1);
+  mapped->buffer = gst_buffer_ref(gst_sample_get_buffer(sample));
+  gst_sample_unref(sample);
 
-GstFlowReturn StreamSource::AudioAppSinkSampleAddedCB(GstElement *element, gpointer userData)
-{
-  StreamSource *streamSrc = reinterpret_cast<StreamSource *>(userData);
-  gchar* elementName = gst_element_get_name(element);
-  MEDIA_STATUS_T ret;
-  GstElement* pipeline = streamSrc->media_player_client_->GetPipeline();
-  if (!pipeline)
+  if (!gst_buffer_map(mapped->buffer, &mapped->mapInfo, GST_MAP_READ)) {
+    gst_buffer_unref(mapped->buffer);
+    g_free(mapped);
     return GST_FLOW_ERROR;
+  }
 
-  GstElement* source = gst_bin_get_by_name(GST_BIN(pipeline), "audio-app-es");
+  guint8* bufferData = reinterpret_cast<guint8 *>(mapped->mapInfo.data);
+  guint32 bufferSize = mapped->mapInfo.size;
 
-  /* get the sample from appsink */
-  GstSample* sample = gst_app_sink_pull_sample(GST_APP_SINK(element));
-  GstBuffer* buffer = gst_sample_get_buffer(sample);
+  if (feedStartTime_ == 0)
+    feedStartTime_ = g_get_monotonic_time();
 
-  /* make a copy */
-  GstBuffer* appBuffer = gst_buffer_copy(buffer);
-  GST_BUFFER_PTS(appBuffer) = GST_CLOCK_TIME_NONE;
+  MEDIA_STATUS_T ret = media_player_client_->FeedWrapped(bufferData, bufferSize,
+      GST_CLOCK_TIME_NONE, esData, ReleaseMappedBuffer, mapped);
 
-  /* we don't need the appsink sample anymore */
-  gst_sample_unref(sample);
+  if (ret == MEDIA_BUFFER_FULL)
+    ReleaseMappedBuffer(mapped);  // ownership stays with us in this case
 
-  // can't use static variable after unload. so added firstAudioSample variable.
-  if (!streamSrc->firstAudioSample) {
-    GstPad* srcPad = gst_element_get_static_pad(source, "src");
-    GstPad* sinkPad = gst_element_get_static_pad(element, "sink");
-    GstCaps* caps = gst_pad_get_current_caps(sinkPad);
-    gst_app_src_set_caps(GST_APP_SRC(source), caps);
-    streamSrc->firstAudioSample = true;
-//    print_caps(caps, "\t");
-    gst_object_unref(srcPad);
-    gst_object_unref(sinkPad);
-  }
+  if (ret != MEDIA_OK)
+    return GST_FLOW_ERROR;
 
-  /* get buffer and size from Gstbuffer */
-  GstMapInfo mapInfo;
-  gst_buffer_map(appBuffer, &mapInfo, GST_MAP_READ);
+  fedUnits_++;
+  fedBytes_ += bufferSize;
+  return GST_FLOW_OK;
+}
 
-  guint8* bufferData = reinterpret_cast<guint8 *>(mapInfo.data);
-  guint32 bufferSize = mapInfo.size;
+void StreamSource::ReleaseMappedBuffer(gpointer data)
+{
+  MappedBuffer* mapped = static_cast<MappedBuffer*>(data);
+  gst_buffer_unmap(mapped->buffer, &mapped->mapInfo);
+  gst_buffer_unref(mapped->buffer);
+  g_free(mapped);
+}
 
-  ret = streamSrc->media_player_client_->Feed(bufferData, bufferSize, GST_CLOCK_TIME_NONE, MEDIA_DATA_CH_B);
+void StreamSource::PrintThroughput()
+{
+  gint64 startTime = feedStartTime_;
+  if (startTime == 0) {
+    std::cout << std::string("Nothing fed yet!") << std::endl;
+    return;
+  }
 
-  gst_buffer_unmap(appBuffer, &mapInfo);
-  g_free(elementName);
-  gst_object_unref(source);
+  double elapsed = (g_get_monotonic_time() - startTime) / (double)G_USEC_PER_SEC;
+  if (elapsed <= 0)
+    return;
 
-  if (ret == MEDIA_OK)
-    return GST_FLOW_OK;
-  else
-    return GST_FLOW_ERROR;
+  guint64 units = fedUnits_;
+  guint64 bytes = fedBytes_;
+  std::cout << "fed " << units << " AUs, " << bytes << " bytes in "
+            << elapsed << " sec" << std::endl;
+  std::cout << "\t" << units / elapsed << " AUs/sec, "
+            << bytes / elapsed / (1024 * 1024) << " MB/sec" << std::endl;
+
+  MEDIA_FEED_STATS_T stats;
+  if (media_player_client_ &&
+      media_player_client_->GetFeedStats(MEDIA_DATA_CH_A, &stats))
+    std::cout << "\tvideo pool hit/miss: " << stats.poolHits << "/"
+              << stats.poolMisses << std::endl;
+  if (media_player_client_ &&
+      media_player_client_->GetFeedStats(MEDIA_DATA_CH_B, &stats))
+    std::cout << "\taudio pool hit/miss: " << stats.poolHits << "/"
+              << stats.poolMisses << std::endl;
 }
 
 bool StreamSource::CreatePipeLine()
@@ -520,6 +531,9 @@ void StreamSource::ClearResources()
 
   firstVideoSample = false;
   firstAudioSample = false;
+  fedUnits_ = 0;
+  fedBytes_ = 0;
+  feedStartTime_ = 0;
 
   std::cout << "clear Done!" << std::endl;
 }
@@ -18,6 +18,7 @@
 #ifndef STREAM_SOURCE_H_
 #define STREAM_SOURCE_H_
 
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -50,11 +51,21 @@ class StreamSource {
     static GstFlowReturn AudioAppSinkSampleAddedCB(GstElement *element, gpointer userData);
     static void ParseBinPadAddedCB(GstElement* element, GstPad* pad, gpointer userData);
     static void MultiQueuePadAddedCB(GstElement* element, GstPad* pad, gpointer userData);
+    void PrintThroughput();
 
     StreamSource(const StreamSource &) = delete;
     StreamSource& operator=(const StreamSource &) = delete;
     StreamSource& operator=(StreamSource &&) = delete;
   private:
+    struct MappedBuffer {
+      GstBuffer* buffer;
+      GstMapInfo mapInfo;
+    };
+
+    GstFlowReturn FeedSample(GstElement *element, const gchar *srcName,
+                             MEDIA_DATA_CHANNEL_T esData, bool &firstSample);
+    static void ReleaseMappedBuffer(gpointer data);
+
     std::string uri_;
     std::string windowID_;
     std::string appID_;
@@ -77,6 +88,11 @@ class StreamSource {
     bool firstVideoSample;
     bool firstAudioSample;
 
+    /* throughput counters, updated from both appsink threads */
+    std::atomic<guint64> fedUnits_ { 0 };
+    std::atomic<guint64> fedBytes_ { 0 };
+    std::atomic<gint64> feedStartTime_ { 0 };
+
     std::vector<GstPad*> multiQueueSinkPads_;
     std::unique_ptr<gmp::player::MediaPlayerClient> media_player_client_;
 };
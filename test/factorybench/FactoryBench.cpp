@@ -0,0 +1,175 @@
+// Copyright (c) 2020 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+/* ElementFactory micro-benchmark.
+ *
+ * Replays the config lookups and element creations of one BufferPlayer
+ * Load, once against the cached config table and once with a copy of the
+ * ElementFactory code that re-read the file for every lookup.
+ *
+ *   elementfactory_bench [iterations]
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <gst/gst.h>
+#include <pbnjson.hpp>
+#include <ElementFactory.h>
+
+#define DEFAULT_ITERATIONS 200
+
+namespace {
+
+const char *kLoadElements[] = {
+  "video-codec-h264",
+  "vaapi-postproc",
+  "video-queue",
+  "video-converter",
+  "video-sink",
+  "audio-codec-aac",
+  "audio-sink",
+};
+
+void Unref(GstElement *element) {
+  if (element)
+    gst_object_unref(gst_object_ref_sink(element));
+}
+
+/* ElementFactory before the cached table, kept verbatim apart from the
+ * file path, the logging and a generic getter standing in for the ones
+ * added since, which would have parsed the file the same way. */
+pbnjson::JValue LegacyReadFile() {
+  return pbnjson::JDomParser::fromFile(g_getenv("GMP_GST_ELEMENTS_CONF"));
+}
+
+void LegacyGetKey(const char *key) {
+  pbnjson::JValue root = LegacyReadFile();
+  if (root.isObject() && root.hasKey(key))
+    root[key].asNumber<int32_t>();
+}
+
+std::string LegacyGetPlatform() {
+  pbnjson::JValue root = LegacyReadFile();
+  std::string strReturn = std::string("");
+  pbnjson::JValue jvPlatform = root["platform"];
+  if (jvPlatform.isString())
+    strReturn = root["platform"].asString();
+  return strReturn;
+}
+
+void LegacySetProperty(GstElement *element, const pbnjson::JValue &prop,
+                       const pbnjson::JValue &value) {
+  if (!prop.isString())
+    return;
+  std::string strProp = prop.asString();
+  if (value.isNumber())
+    g_object_set(G_OBJECT(element), strProp.c_str(), value.asNumber<gint32>(), nullptr);
+  else if (value.isString())
+    g_object_set(G_OBJECT(element), strProp.c_str(), value.asString().c_str(), nullptr);
+  else if (value.isBoolean())
+    g_object_set(G_OBJECT(element), strProp.c_str(), value.asBool(), nullptr);
+}
+
+std::string LegacyGetPreferredElementName(const std::string &elementTypeName) {
+  pbnjson::JValue root = LegacyReadFile();
+  if (!root.isObject())
+    return std::string("");
+
+  pbnjson::JValue elements = root["gst_elements"];
+  int i = CUSTOM_PLAYER_PIPELINE;
+  if (elements[i].hasKey(elementTypeName)
+    && elements[i][elementTypeName].hasKey("name"))
+    return elements[i][elementTypeName]["name"].asString();
+  return std::string("");
+}
+
+GstElement * LegacyCreate(const std::string &elementTypeName) {
+  GstElement * element = gst_element_factory_make(
+      LegacyGetPreferredElementName(elementTypeName).c_str(),
+      elementTypeName.c_str());
+  pbnjson::JValue root = LegacyReadFile();
+  if (!root.isObject())
+    return element;
+
+  pbnjson::JValue elements = root["gst_elements"];
+  int i = CUSTOM_PLAYER_PIPELINE;
+  if (element && elements[i].hasKey(elementTypeName)
+    && elements[i][elementTypeName].hasKey("name")
+    && elements[i][elementTypeName].hasKey("properties")) {
+    for (auto it : elements[i][elementTypeName]["properties"].children())
+      LegacySetProperty(element, it.first, it.second);
+  }
+  return element;
+}
+
+void SimulateLoad(bool legacy) {
+  using gmp::pf::ElementFactory;
+
+  if (legacy) {
+    LegacyGetKey("use_audio");
+    LegacyGetPlatform();  // NOTIFY_ACQUIRE_RESOURCE
+    LegacyGetKey("allow_no_window");
+    LegacyGetKey("memory_budget_mb");
+    for (const char *name : kLoadElements)
+      Unref(LegacyCreate(name));
+    return;
+  }
+
+  ElementFactory::GetUseAudioProperty();
+  ElementFactory::GetPlatform();  // NOTIFY_ACQUIRE_RESOURCE
+  ElementFactory::GetAllowNoWindow();
+  ElementFactory::GetMemoryBudget();
+  for (const char *name : kLoadElements)
+    Unref(ElementFactory::Create("custom", name));
+}
+
+double Measure(bool legacy, int iterations) {
+  gint64 start = g_get_monotonic_time();
+  for (int i = 0; i < iterations; i++)
+    SimulateLoad(legacy);
+  return (g_get_monotonic_time() - start) / static_cast<double>(iterations);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  int iterations = DEFAULT_ITERATIONS;
+  if (argc > 1)
+    iterations = std::max(1, atoi(argv[1]));
+
+  g_setenv("GMP_GST_ELEMENTS_CONF", BENCH_CONF_DIR "/gst_elements.conf", FALSE);
+  gst_init(&argc, &argv);
+
+  // warm up gst's plugin registry so neither run pays for it
+  SimulateLoad(false);
+  SimulateLoad(true);
+
+  double legacy = Measure(true, iterations);
+  double cached = Measure(false, iterations);
+
+  printf("config: %s\n", g_getenv("GMP_GST_ELEMENTS_CONF"));
+  printf("per Load, %d iterations:\n", iterations);
+  printf("  re-parse per lookup: %9.1f usec\n", legacy);
+  printf("  cached table:        %9.1f usec\n", cached);
+  if (cached > 0)
+    printf("  speedup:             %9.1fx\n", legacy / cached);
+
+  return 0;
+}
@@ -0,0 +1,198 @@
+// Copyright (c) 2020 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+/* Notification serializer micro-benchmark.
+ *
+ * Builds the currentTime, bufferRange and playing payloads of
+ * Service::Notify with the pbnjson Composer and with the streaming
+ * Writer, and reports notifications per second and heap allocations per
+ * notification for each. Allocations are counted by wrapping glibc's
+ * malloc family, which also catches the ones made inside pbnjson.
+ *
+ *   notify_bench [iterations]
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <glib.h>
+#include <pbnjson.hpp>
+#include <base/types.h>
+#include <parser/composer.h>
+#include <parser/writer.h>
+
+#define DEFAULT_ITERATIONS 100000
+
+namespace {
+
+bool g_counting = false;
+size_t g_allocations = 0;
+
+}  // namespace
+
+extern "C" {
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t nmemb, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) {
+  if (g_counting)
+    g_allocations++;
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size) {
+  if (g_counting)
+    g_allocations++;
+  return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  if (g_counting)
+    g_allocations++;
+  return __libc_realloc(ptr, size);
+}
+
+}  // extern "C"
+
+namespace {
+
+enum class Kind { CURRENT_TIME, BUFFER_RANGE, PLAYING };
+
+struct Case {
+  const char *name;
+  Kind kind;
+};
+
+const Case kCases[] = {
+  { "currentTime", Kind::CURRENT_TIME },
+  { "bufferRange", Kind::BUFFER_RANGE },
+  { "playing", Kind::PLAYING },
+};
+
+const gmp::base::buffer_range_t kRange = { 12000, 42000, 30000, 71 };
+const gmp::base::media_info_t kMediaInfo = { "_dPG8v3e9kM98mI" };
+
+// What Service::Notify did for every notification before the Writer.
+std::string ComposeLegacy(Kind kind, gmp::base::time_t position) {
+  gmp::parser::Composer composer;
+  switch (kind) {
+    case Kind::CURRENT_TIME:
+      composer.put("currentTime", position);
+      break;
+    case Kind::BUFFER_RANGE:
+      composer.put("bufferRange", kRange);
+      break;
+    case Kind::PLAYING:
+      composer.put("playing", kMediaInfo);
+      break;
+  }
+  return composer.result();
+}
+
+const std::string & Write(gmp::parser::Writer *writer, Kind kind,
+                          gmp::base::time_t position) {
+  switch (kind) {
+    case Kind::CURRENT_TIME:
+      return writer->put("currentTime", position);
+    case Kind::BUFFER_RANGE:
+      return writer->put("bufferRange", kRange);
+    case Kind::PLAYING:
+      break;
+  }
+  return writer->put("playing", kMediaInfo);
+}
+
+struct Result {
+  double per_second;
+  double allocations;
+};
+
+Result MeasureLegacy(Kind kind, int iterations) {
+  size_t length = 0;
+  g_allocations = 0;
+  g_counting = true;
+  gint64 start = g_get_monotonic_time();
+  for (int i = 0; i < iterations; i++)
+    length += ComposeLegacy(kind, i * 200).size();
+  gint64 elapsed = g_get_monotonic_time() - start;
+  g_counting = false;
+
+  if (!length)
+    printf("empty payloads\n");
+  return { iterations * 1e6 / std::max<gint64>(elapsed, 1),
+           g_allocations / static_cast<double>(iterations) };
+}
+
+Result MeasureWriter(Kind kind, int iterations) {
+  gmp::parser::Writer writer;
+  Write(&writer, kind, 0);  // Service keeps one writer per thread, warm it up
+
+  size_t length = 0;
+  g_allocations = 0;
+  g_counting = true;
+  gint64 start = g_get_monotonic_time();
+  for (int i = 0; i < iterations; i++)
+    length += Write(&writer, kind, i * 200).size();
+  gint64 elapsed = g_get_monotonic_time() - start;
+  g_counting = false;
+
+  if (!length)
+    printf("empty payloads\n");
+  return { iterations * 1e6 / std::max<gint64>(elapsed, 1),
+           g_allocations / static_cast<double>(iterations) };
+}
+
+// Both payloads must parse to the same document.
+bool SamePayload(Kind kind) {
+  gmp::parser::Writer writer;
+  pbnjson::JDomParser legacy;
+  pbnjson::JDomParser current;
+  if (!legacy.parse(ComposeLegacy(kind, 734250)) ||
+      !current.parse(Write(&writer, kind, 734250)))
+    return false;
+  return legacy.getDom() == current.getDom();
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  int iterations = DEFAULT_ITERATIONS;
+  if (argc > 1)
+    iterations = std::max(1, atoi(argv[1]));
+
+  int mismatches = 0;
+  printf("%d notifications each:\n", iterations);
+  printf("  %-12s %14s %10s %14s %10s\n", "payload",
+         "composer n/s", "allocs", "writer n/s", "allocs");
+  for (const Case &c : kCases) {
+    Result legacy = MeasureLegacy(c.kind, iterations);
+    Result writer = MeasureWriter(c.kind, iterations);
+    printf("  %-12s %14.0f %10.2f %14.0f %10.2f\n", c.name,
+           legacy.per_second, legacy.allocations,
+           writer.per_second, writer.allocations);
+    if (!SamePayload(c.kind)) {
+      printf("  %-12s payloads differ\n", c.name);
+      mismatches++;
+    }
+  }
+
+  return mismatches ? 1 : 0;
+}
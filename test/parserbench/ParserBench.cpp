@@ -0,0 +1,160 @@
+// Copyright (c) 2020 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SPDX-License-Identifier: Apache-2.0
+
+/* Parser::get_start_time micro-benchmark.
+ *
+ * Runs the start time lookup of UriPlayer::Load on a few UMS load
+ * payloads, once with the regex scan Parser used to do and once with the
+ * current structured lookup. Parsing the payload is left out of both.
+ *
+ *   parser_bench [iterations]
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <regex>
+#include <string>
+
+#include <glib.h>
+#include <pbnjson.hpp>
+#include <parser/parser.h>
+
+#define DEFAULT_ITERATIONS 10000
+
+namespace {
+
+struct Payload {
+  const char *name;
+  const char *json;
+};
+
+const Payload kPayloads[] = {
+  { "plain",
+    R"({"id":"_dPG8v3e9kM98mI","uri":"file:///media/internal/sintel.mp4"})" },
+  { "browser",
+    R"({"options":{"option":{"windowId":"_Window_Id_1",)"
+    R"("useSeekableRanges":true,"videoDisplayMode":"Textured",)"
+    R"("appId":"com.webos.app.mediaevents-test","needAudio":true,)"
+    R"("bufferControl":{"userBufferCtrl":false},"transmission":)"
+    R"({"httpHeader":{"referer":"https://www.w3.org/2010/05/video/)"
+    R"(mediaevents.html","userAgent":"Mozilla/5.0 (Web0S; Linux) )"
+    R"(AppleWebKit/537.36 (KHTML, like Gecko) Chrome/72.0.3626.121 )"
+    R"(Safari/537.36 WebAppManager","cookies":""}},"preload":"false"}},)"
+    R"("id":"_dPG8v3e9kM98mI",)"
+    R"("uri":"https://media.w3.org/2010/05/sintel/trailer.mp4"})" },
+  { "resume",
+    R"({"options":{"option":{"windowId":"_Window_Id_3",)"
+    R"("videoDisplayMode":"Textured","appId":"com.webos.app.videoplayer",)"
+    R"("needAudio":true,"mediaTransportType":"URI",)"
+    R"("bufferControl":{"userBufferCtrl":false,"bufferMinLevel":0,)"
+    R"("bufferMaxLevel":0},"adaptiveStreaming":{"maxWidth":1920,)"
+    R"("maxHeight":1080,"maxFrameRate":60},)"
+    R"("transmission":{"httpHeader":{"userAgent":"Mozilla/5.0 (Web0S; )"
+    R"(Linux) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/72.0.3626.121 )"
+    R"(Safari/537.36 WebAppManager","cookies":"session=4f1d2c; lang=en"},)"
+    R"("playTime":{"start":734250}},"preload":"true",)"
+    R"("externalStreamingInfo":{"contents":{"codec":{"video":"H264",)"
+    R"("audio":"AAC"},"esInfo":{"pid":0,"ptsToDecode":0}}},)"
+    R"("lgSpecificOption":{"seekMode":"late_Iframe","startBPS":0}}},)"
+    R"("id":"_n3Qx0aW2rT7yZ1","uri":"file:///media/internal/movies/)"
+    R"(Big_Buck_Bunny_1080p_h264_aac.mp4"})" },
+};
+
+/* Parser::get_start_time before the structured lookup, kept verbatim
+ * apart from taking the DOM as an argument. */
+gint64 LegacyGetStartTime(pbnjson::JValue dom) {
+  gint64 start_time = 0;
+  std::string serialized;
+  for (auto i : dom.children()) {
+    serialized = pbnjson::JGenerator::serialize(i.second, true);
+
+    try {
+      std::regex re("\\w+");
+      std::sregex_iterator next(serialized.begin(), serialized.end(), re);
+      std::sregex_iterator end;
+      while (next != end) {
+        std::smatch match = *next;
+        if (match.str() == "start") {
+          ++next;
+          match = *next;
+          start_time = std::stoll(match.str(), NULL, 10);
+          break;
+        }
+        ++next;
+      }
+    } catch (std::regex_error& e) {
+      printf("Syntax error in the regular expression\n");
+    }
+
+    if (start_time > 0)
+      break;
+  }
+
+  return start_time;
+}
+
+double MeasureLegacy(const char *json, int iterations, gint64 *result) {
+  pbnjson::JDomParser parser;
+  parser.parse(json);
+  pbnjson::JValue dom = parser.getDom();
+
+  gint64 start = g_get_monotonic_time();
+  for (int i = 0; i < iterations; i++)
+    *result = LegacyGetStartTime(dom);
+  return (g_get_monotonic_time() - start) / static_cast<double>(iterations);
+}
+
+double MeasureCurrent(const char *json, int iterations, gint64 *result) {
+  gmp::parser::Parser parser(json);
+
+  gint64 start = g_get_monotonic_time();
+  for (int i = 0; i < iterations; i++)
+    *result = parser.get_start_time();
+  return (g_get_monotonic_time() - start) / static_cast<double>(iterations);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  int iterations = DEFAULT_ITERATIONS;
+  if (argc > 1)
+    iterations = std::max(1, atoi(argv[1]));
+
+  int mismatches = 0;
+  printf("per lookup, %d iterations:\n", iterations);
+  printf("  %-8s %8s %12s %12s %9s\n",
+         "payload", "start", "regex usec", "lookup usec", "speedup");
+  for (const Payload &payload : kPayloads) {
+    gint64 legacy_start = 0;
+    gint64 start = 0;
+    double legacy = MeasureLegacy(payload.json, iterations, &legacy_start);
+    double current = MeasureCurrent(payload.json, iterations, &start);
+
+    printf("  %-8s %8lld %12.2f %12.2f %8.1fx\n", payload.name,
+           static_cast<long long>(start), legacy, current,
+           current > 0 ? legacy / current : 0.0);
+    if (start != legacy_start) {
+      printf("  %-8s mismatch: regex %lld, lookup %lld\n", payload.name,
+             static_cast<long long>(legacy_start),
+             static_cast<long long>(start));
+      mismatches++;
+    }
+  }
+
+  return mismatches ? 1 : 0;
+}